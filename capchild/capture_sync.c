@@ -1742,6 +1742,25 @@ sync_pipe_input_cb(gint source, gpointer user_data)
         cap_session->drops(cap_session, num, name);
         break;
         }
+    case SP_QUEUE_STATS: {
+        /* <interface>:<depth>:<max depth>:<slots>:<dropped> */
+        guint32 values[5];
+        const gchar* end = buffer;
+        int i;
+
+        for (i = 0; i < 5; i++) {
+            if (!ws_strtou32(end, &end, &values[i]) || (i < 4 && *end++ != ':'))
+                break;
+        }
+        if (i < 5) {
+            g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_WARNING, "Invalid queue statistics: %s", buffer);
+            break;
+        }
+        g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_INFO,
+              "Queue of interface %u: %u packets queued, at most %u of %u slots used, %u packets dropped",
+              values[0], values[1], values[2], values[3], values[4]);
+        break;
+        }
     default:
         g_assert_not_reached();
     }
@@ -988,8 +988,16 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
             ;
         } else if (strcmp(optarg_str_p, "gzip") == 0) {
             ;
+#ifdef HAVE_ZSTD
+        } else if (strcmp(optarg_str_p, "zstd") == 0) {
+            ;
+#endif
         } else {
+#ifdef HAVE_ZSTD
+            cmdarg_err("parameter of --compress-type can be 'none', 'gzip' or 'zstd'");
+#else
             cmdarg_err("parameter of --compress-type can be 'none' or 'gzip'");
+#endif
             return 1;
         }
         capture_opts->compress_type = g_strdup(optarg_str_p);
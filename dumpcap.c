@@ -116,11 +116,28 @@ FILE *debug_log;   /* for logging debug messages to  */
                    /*  is defined                    */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
-static gint64 pcap_queue_packets;
+/*
+ * With more than one capture source, or with -t, each source is read in
+ * its own thread, and the packets are queued for the main thread to write
+ * in a ring of preallocated slots per source. The rings are
+ * single-producer, single-consumer, so they need no locks; the mutex and
+ * condition are only used to wake up the writer when all rings are empty.
+ *
+ * The counters are pointer-sized so that they can be updated atomically;
+ * they're 64-bit on 64-bit platforms, and on others the limits are below
+ * 2^31, so they can't wrap.
+ */
+static volatile gsize pcap_queue_bytes;
+static volatile gsize pcap_queue_packets;
+static volatile gsize pcap_queue_buffer_bytes;  /* Allocated in the slots */
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
+static gsize pcap_queue_keep_bytes;             /* Most buffer bytes kept for reuse */
+static size_t io_buffer_size = 0;  /* --io-buffer-size, or 0 for the default */
+#define MAX_IO_BUFFER_SIZE_KIB  (1024 * 1024)
+static GMutex pcap_queue_mtx;
+static GCond pcap_queue_cond;
+static volatile gint pcap_queue_writer_waiting;
 
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 #ifdef _WIN32
@@ -184,6 +201,43 @@ typedef struct _pcapng_pipe_info {
 } pcapng_pipe_info_t;
 
 struct _loop_data; /* forward declaration so we can use it in the cap_pipe_dispatch function pointer */
+struct _capture_src;
+
+typedef struct _pcap_queue_element {
+    struct _capture_src *pcap_src;
+    union {
+        struct pcap_pkthdr  phdr;
+        pcapng_block_header_t  bh;
+    } u;
+    u_char             *pd;
+    size_t              pd_size;        /**< Allocated size of pd */
+} pcap_queue_element;
+
+/*
+ * Ring of queued packets of a capture source. head and tail count the
+ * packets queued and written so far; only the capture thread of the
+ * source sets head, and only the writer sets tail.
+ */
+typedef struct _pcap_queue {
+    pcap_queue_element *elements;       /**< Preallocated slots */
+    guint               size;           /**< Number of slots, a power of two */
+    volatile gint       head;           /**< Slots filled, set by the capture thread */
+    volatile gint       tail;           /**< Slots written, set by the writer */
+    guint               writer_head;    /**< head as last seen by the writer */
+    guint               writer_tail;    /**< Slots written but not yet released */
+    guint               max_depth;      /**< Largest number of slots in use */
+    guint               backpressure;   /**< Times the queue became 3/4 full */
+    gboolean            filling_up;     /**< TRUE while it's more than half full */
+} pcap_queue;
+
+/* Most slots in the ring of a source, fewer with a lower packet limit */
+#define PCAP_QUEUE_DEFAULT_SLOTS    65536
+/* Largest packet buffer that is kept in a slot for reuse */
+#define PCAP_QUEUE_SLOT_KEEP_SIZE   16384
+/* Buffer bytes kept for reuse in all slots when there's no byte limit */
+#define PCAP_QUEUE_KEEP_BYTES       (16 * 1024 * 1024)
+/* Most packets written by the writer before releasing their slots */
+#define PCAP_QUEUE_BATCH            64
 
 /*
  * A source of packets from which we're capturing.
@@ -199,6 +253,7 @@ typedef struct _capture_src {
     gboolean                     pcap_err;
     guint                        interface_id;
     GThread                     *tid;
+    pcap_queue                   queue;                  /**< Packets queued by the thread */
     int                          snaplen;
     int                          linktype;
     gboolean                     ts_nsec;                /**< TRUE if we're using nanosecond precision. */
@@ -274,15 +329,6 @@ typedef struct _loop_data {
     int      interval_s;
 } loop_data;
 
-typedef struct _pcap_queue_element {
-    capture_src        *pcap_src;
-    union {
-        struct pcap_pkthdr  phdr;
-        pcapng_block_header_t  bh;
-    } u;
-    u_char             *pd;
-} pcap_queue_element;
-
 /*
  * This needs to be static, so that the SIGINT handler can clear the "go"
  * flag and for saved_shb_idb_lock.
@@ -351,6 +397,7 @@ static void WS_NORETURN exit_main(int err);
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_queue_stats(void);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
@@ -427,6 +474,12 @@ print_usage(FILE *output)
     fprintf(output, "                                          an exact multiple of NUM secs\n");
     fprintf(output, "                          printname:FILE - print filename to FILE when written\n");
     fprintf(output, "                                           (can use 'stdout' or 'stderr')\n");
+    fprintf(output, "  --compress-type <type>   compress files after switching to the next one\n");
+#ifdef HAVE_ZSTD
+    fprintf(output, "                           (none, gzip or zstd; def: none)\n");
+#else
+    fprintf(output, "                           (none or gzip; def: none)\n");
+#endif
     fprintf(output, "  -n                       use pcapng format instead of pcap (default)\n");
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
     fprintf(output, "  --capture-comment <comment>\n");
@@ -438,6 +491,8 @@ print_usage(FILE *output)
     fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
     fprintf(output, "                           within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
+    fprintf(output, "  --io-buffer-size <KiB>   size of the buffer used to write the output file\n");
+    fprintf(output, "                           (def: %d KiB or the file system block size)\n", IO_BUF_SIZE / 1024);
     fprintf(output, "  -q                       don't report packet capture counts\n");
     fprintf(output, "  -v, --version            print version information and exit\n");
     fprintf(output, "  -h, --help               display this help and exit\n");
@@ -3191,12 +3246,15 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
         if (ld->pdh == NULL) {
             err = errno;
         } else {
-            size_t buffsize = IO_BUF_SIZE;
+            size_t buffsize = io_buffer_size ? io_buffer_size : IO_BUF_SIZE;
 #ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
             ws_statb64 statb;
 
-            if (ws_fstat64(ld->save_file_fd, &statb) == 0) {
-                if (statb.st_blksize > IO_BUF_SIZE) {
+            if (ws_fstat64(ld->save_file_fd, &statb) == 0 && statb.st_blksize > 0) {
+                if (io_buffer_size) {
+                    /* Write whole file system blocks */
+                    buffsize = (buffsize + statb.st_blksize - 1) / statb.st_blksize * statb.st_blksize;
+                } else if (statb.st_blksize > IO_BUF_SIZE) {
                     buffsize = statb.st_blksize;
                 }
             }
@@ -3572,6 +3630,7 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                                              (capture_opts->has_ring_num_files) ? capture_opts->ring_num_files : 0,
                                              capture_opts->group_read_access,
                                              capture_opts->compress_type);
+                ringbuf_set_io_buffer_size(io_buffer_size);
 
                 /* capfile_name is unused as the ringbuffer provides its own filename. */
                 if (*save_file_fd != -1) {
@@ -3799,46 +3858,185 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
+/* Allocate the ring of queued packets of a capture source */
+static void
+pcap_queue_init(capture_src *pcap_src)
+{
+    pcap_queue *queue = &pcap_src->queue;
+    gint64      slots;
+    guint       i;
+
+    /*
+     * The packet limit applies to all sources together, and is checked
+     * by pcap_queue_reserve(); don't allocate a slot for each packet of
+     * a huge limit up front.
+     */
+    slots = PCAP_QUEUE_DEFAULT_SLOTS;
+    if (pcap_queue_packet_limit > 0 && pcap_queue_packet_limit < slots) {
+        slots = pcap_queue_packet_limit;
+    }
+    for (queue->size = 1; queue->size < slots && queue->size < G_MAXINT / 2 + 1; queue->size <<= 1)
+        ;
+    queue->elements = g_new0(pcap_queue_element, queue->size);
+    for (i = 0; i < queue->size; i++) {
+        queue->elements[i].pcap_src = pcap_src;
+    }
+    queue->head = 0;
+    queue->tail = 0;
+    queue->writer_head = 0;
+    queue->writer_tail = 0;
+    queue->max_depth = 0;
+    queue->backpressure = 0;
+    queue->filling_up = FALSE;
+}
+
+/* Free the ring of queued packets of a capture source */
+static void
+pcap_queue_free(capture_src *pcap_src)
+{
+    pcap_queue *queue = &pcap_src->queue;
+    guint       i;
+
+    for (i = 0; i < queue->size; i++) {
+        g_free(queue->elements[i].pd);
+    }
+    g_free(queue->elements);
+    queue->elements = NULL;
+    queue->size = 0;
+}
+
+/*
+ * Look for newly queued packets. Returns TRUE if any capture source has
+ * queued packets that haven't been written yet.
+ */
 static gboolean
-capture_loop_dequeue_packet(void) {
+pcap_queue_poll(void)
+{
+    capture_src *pcap_src;
+    gboolean     pending = FALSE;
+    guint        i;
+
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        pcap_src->queue.writer_head = (guint)g_atomic_int_get(&pcap_src->queue.head);
+        if (pcap_src->queue.writer_head != pcap_src->queue.writer_tail) {
+            pending = TRUE;
+        }
+    }
+    return pending;
+}
+
+/* Time stamp of a queued element, in nanoseconds, for ordering */
+static gint64
+pcap_queue_element_ts(const pcap_queue_element *queue_element)
+{
+    const struct pcap_pkthdr *phdr = &queue_element->u.phdr;
+
+    /* tv_usec holds nanoseconds with nanosecond precision */
+    return (gint64)phdr->ts.tv_sec * 1000000000 +
+           (queue_element->pcap_src->ts_nsec ? phdr->ts.tv_usec : (gint64)phdr->ts.tv_usec * 1000);
+}
+
+/*
+ * Write the packets queued by the capture threads, up to
+ * PCAP_QUEUE_BATCH of them, waiting a bit for some if there are none.
+ * The packets queued for different sources are written in time stamp
+ * order; pcapng blocks, which we don't look into, are written first.
+ * Returns the number of packets written.
+ */
+static int
+capture_loop_dequeue_packets(void) {
+    capture_src        *pcap_src;
     pcap_queue_element *queue_element;
+    gsize               bytes = 0;
+    int                 count = 0;
+    guint               i;
 
-    g_async_queue_lock(pcap_queue);
-    queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
+    if (!pcap_queue_poll()) {
+        g_mutex_lock(&pcap_queue_mtx);
+        g_atomic_int_set(&pcap_queue_writer_waiting, 1);
+        if (!pcap_queue_poll()) {
+            g_cond_wait_until(&pcap_queue_cond, &pcap_queue_mtx,
+                              g_get_monotonic_time() + WRITER_THREAD_TIMEOUT);
+        }
+        g_atomic_int_set(&pcap_queue_writer_waiting, 0);
+        g_mutex_unlock(&pcap_queue_mtx);
+        if (!pcap_queue_poll()) {
+            return 0;
         }
-        pcap_queue_packets -= 1;
     }
-    g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
+
+    while (count < PCAP_QUEUE_BATCH) {
+        capture_src *next_src = NULL;
+        gint64       next_ts = 0;
+
+        /* Pick the earliest of the next packets of all sources */
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_queue *queue;
+
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            queue = &pcap_src->queue;
+            if (queue->writer_tail == queue->writer_head)
+                continue;
+            if (pcap_src->from_pcapng) {
+                next_src = pcap_src;
+                break;
+            }
+            queue_element = &queue->elements[queue->writer_tail & (queue->size - 1)];
+            if (next_src == NULL || pcap_queue_element_ts(queue_element) < next_ts) {
+                next_src = pcap_src;
+                next_ts = pcap_queue_element_ts(queue_element);
+            }
+        }
+        if (next_src == NULL)
+            break;
+
+        queue_element = &next_src->queue.elements[next_src->queue.writer_tail & (next_src->queue.size - 1)];
+        if (next_src->from_pcapng) {
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
                   "Dequeued a block of type 0x%08x of length %d captured on interface %d.",
                   queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
-                  queue_element->pcap_src->interface_id);
+                  next_src->interface_id);
 
-            capture_loop_write_pcapng_cb(queue_element->pcap_src,
+            capture_loop_write_pcapng_cb(next_src,
                                         &queue_element->u.bh,
                                         queue_element->pd);
+            bytes += queue_element->u.bh.block_total_length;
         } else {
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
                 "Dequeued a packet of length %d captured on interface %d.",
-                queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
+                queue_element->u.phdr.caplen, next_src->interface_id);
 
-            capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
+            capture_loop_write_packet_cb((u_char *) next_src,
                                         &queue_element->u.phdr,
                                         queue_element->pd);
+            bytes += queue_element->u.phdr.caplen;
         }
-        g_free(queue_element->pd);
-        g_free(queue_element);
-        return TRUE;
+        /*
+         * Don't hold on to the buffers of unusually large packets, nor
+         * to more buffer space than we're allowed to queue, or a burst
+         * would leave a buffer in every slot of the ring.
+         */
+        if (queue_element->pd_size > PCAP_QUEUE_SLOT_KEEP_SIZE ||
+            (gsize)g_atomic_pointer_get(&pcap_queue_buffer_bytes) > pcap_queue_keep_bytes) {
+            g_atomic_pointer_add(&pcap_queue_buffer_bytes, -(gssize)queue_element->pd_size);
+            g_free(queue_element->pd);
+            queue_element->pd = NULL;
+            queue_element->pd_size = 0;
+        }
+        next_src->queue.writer_tail++;
+        count++;
     }
-    return FALSE;
+
+    /* Give the slots back to the capture threads */
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        g_atomic_int_set(&pcap_src->queue.tail, (gint)pcap_src->queue.writer_tail);
+    }
+    g_atomic_pointer_add(&pcap_queue_bytes, -(gssize)bytes);
+    g_atomic_pointer_add(&pcap_queue_packets, -(gssize)count);
+
+    return count;
 }
 
 /*
@@ -4031,9 +4229,15 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
         pcap_queue_bytes = 0;
         pcap_queue_packets = 0;
+        pcap_queue_buffer_bytes = 0;
+        pcap_queue_keep_bytes = pcap_queue_byte_limit > 0 ? (gsize)pcap_queue_byte_limit : PCAP_QUEUE_KEEP_BYTES;
+        pcap_queue_writer_waiting = 0;
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            pcap_queue_init(pcap_src);
+        }
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             /* XXX - Add an interface name here? */
@@ -4043,13 +4247,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-
-            if (dequeued) {
-                inpkts = 1;
-            } else {
-                inpkts = 0;
-            }
+            inpkts = capture_loop_dequeue_packets();
         } else {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, 0);
             inpkts = capture_loop_dispatch(&global_ld, errmsg,
@@ -4129,6 +4327,10 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 global_ld.inpkts_to_sync_pipe = 0;
             }
 
+            if (use_threads) {
+                report_queue_stats();
+            }
+
             /* check capture duration condition */
             if (autostop_duration_timer != NULL && g_timer_elapsed(autostop_duration_timer, NULL) >= capture_opts->autostop_duration) {
                 /* The maximum capture time has elapsed; stop the capture. */
@@ -4164,15 +4366,23 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                   pcap_src->interface_id);
         }
         while (1) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-            if (!dequeued) {
+            int dequeued = capture_loop_dequeue_packets();
+            if (dequeued == 0) {
                 break;
             }
-            global_ld.inpkts_to_sync_pipe += 1;
+            global_ld.inpkts_to_sync_pipe += dequeued;
             if (capture_opts->output_to_pipe) {
                 fflush(global_ld.pdh);
             }
         }
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+                  "Queue of interface %u: %u of %u slots used at most, 3/4 full %u times, %u packets dropped.",
+                  pcap_src->interface_id, pcap_src->queue.max_depth, pcap_src->queue.size,
+                  pcap_src->queue.backpressure, pcap_src->dropped);
+            pcap_queue_free(pcap_src);
+        }
     }
 
 
@@ -4623,6 +4833,90 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     }
 }
 
+/*
+ * Get a free slot in the queue of a capture source, with room for len bytes
+ * of data, or NULL if the queue is full. Called from the capture thread.
+ */
+static pcap_queue_element *
+pcap_queue_reserve(capture_src *pcap_src, guint32 len)
+{
+    pcap_queue         *queue = &pcap_src->queue;
+    pcap_queue_element *queue_element;
+
+    /* The limits are shared by all sources, so this is approximate. */
+    if (((pcap_queue_byte_limit > 0) && ((gsize)g_atomic_pointer_get(&pcap_queue_bytes) >= (guint64)pcap_queue_byte_limit)) ||
+        ((pcap_queue_packet_limit > 0) && ((gsize)g_atomic_pointer_get(&pcap_queue_packets) >= (guint64)pcap_queue_packet_limit))) {
+        return NULL;
+    }
+    if ((guint)queue->head - (guint)g_atomic_int_get(&queue->tail) >= queue->size) {
+        return NULL;
+    }
+
+    queue_element = &queue->elements[(guint)queue->head & (queue->size - 1)];
+    if (queue_element->pd_size < len) {
+        g_free(queue_element->pd);
+        queue_element->pd = (u_char *)g_malloc(len);
+        g_atomic_pointer_add(&pcap_queue_buffer_bytes, (gssize)len - (gssize)queue_element->pd_size);
+        queue_element->pd_size = len;
+    }
+    return queue_element;
+}
+
+/*
+ * Hand the slot returned by pcap_queue_reserve() to the writer, waking
+ * it up if it's waiting. Called from the capture thread.
+ */
+static void
+pcap_queue_commit(capture_src *pcap_src, guint32 len)
+{
+    pcap_queue *queue = &pcap_src->queue;
+    guint       depth;
+    guint64     fill;
+
+    g_atomic_pointer_add(&pcap_queue_bytes, len);
+    g_atomic_pointer_add(&pcap_queue_packets, 1);
+    g_atomic_int_set(&queue->head, (gint)((guint)queue->head + 1));
+
+    depth = (guint)queue->head - (guint)g_atomic_int_get(&queue->tail);
+    if (depth > queue->max_depth) {
+        queue->max_depth = depth;
+    }
+    /*
+     * How full the queue is, in percent, measured against whichever
+     * limit pcap_queue_reserve() will hit first: the slots of the ring,
+     * or the byte and packet limits shared by all sources.
+     */
+    fill = (guint64)depth * 100 / queue->size;
+    if (pcap_queue_byte_limit > 0) {
+        fill = MAX(fill, (guint64)(gsize)g_atomic_pointer_get(&pcap_queue_bytes) * 100 / (guint64)pcap_queue_byte_limit);
+    }
+    if (pcap_queue_packet_limit > 0) {
+        fill = MAX(fill, (guint64)(gsize)g_atomic_pointer_get(&pcap_queue_packets) * 100 / (guint64)pcap_queue_packet_limit);
+    }
+    if (!queue->filling_up && fill >= 75) {
+        /*
+         * The packets are captured faster than they are written. Warn
+         * the first time, unless we're a child, in which case warnings
+         * are shown as errors.
+         */
+        queue->filling_up = TRUE;
+        if (queue->backpressure++ == 0 && !capture_child) {
+            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_WARNING,
+                  "The queue of interface %u is filling up; packets are captured faster than they can be written.",
+                  pcap_src->interface_id);
+        }
+    } else if (queue->filling_up && fill < 50) {
+        /* Count it again only once it has drained a bit */
+        queue->filling_up = FALSE;
+    }
+
+    if (g_atomic_int_get(&pcap_queue_writer_waiting)) {
+        g_mutex_lock(&pcap_queue_mtx);
+        g_cond_signal(&pcap_queue_cond);
+        g_mutex_unlock(&pcap_queue_mtx);
+    }
+}
+
 /* one packet was captured, queue it */
 static void
 capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -4630,7 +4924,6 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
 {
     capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
     pcap_queue_element *queue_element;
-    gboolean            limit_reached;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4640,49 +4933,25 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    queue_element = pcap_queue_reserve(pcap_src, phdr->caplen);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
         pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
-        pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
     } else {
+        queue_element->u.phdr = *phdr;
+        memcpy(queue_element->pd, pd, phdr->caplen);
+        pcap_queue_commit(pcap_src, phdr->caplen);
         pcap_src->received++;
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Queued a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
+    /* The queue may have changed by the time this is logged */
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+          "Queue size is now %" G_GSIZE_FORMAT " bytes (%" G_GSIZE_FORMAT " packets)",
+          (gsize)g_atomic_pointer_get(&pcap_queue_bytes), (gsize)g_atomic_pointer_get(&pcap_queue_packets));
 }
 
 /* one pcapng block was captured, queue it */
@@ -4690,7 +4959,6 @@ static void
 capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd)
 {
     pcap_queue_element *queue_element;
-    gboolean            limit_reached;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4700,49 +4968,25 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    queue_element = pcap_queue_reserve(pcap_src, bh->block_total_length);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.bh = *bh;
-    queue_element->pd = (u_char *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
     } else {
+        queue_element->u.bh = *bh;
+        memcpy(queue_element->pd, pd, bh->block_total_length);
+        pcap_queue_commit(pcap_src, bh->block_total_length);
         pcap_src->received++;
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Queued a block of type 0x%08x of length %d captured on interface %u.",
               bh->block_type, bh->block_total_length, pcap_src->interface_id);
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
+    /* The queue may have changed by the time this is logged */
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+          "Queue size is now %" G_GSIZE_FORMAT " bytes (%" G_GSIZE_FORMAT " packets)",
+          (gsize)g_atomic_pointer_get(&pcap_queue_bytes), (gsize)g_atomic_pointer_get(&pcap_queue_packets));
 }
 
 static int
@@ -4826,9 +5070,12 @@ main(int argc, char *argv[])
 {
     char             *err_msg;
     int               opt;
+#define LONGOPT_IO_BUFFER_SIZE LONGOPT_BASE_APPLICATION+1
+
     static const struct option long_options[] = {
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
+        {"io-buffer-size", required_argument, NULL, LONGOPT_IO_BUFFER_SIZE},
         LONGOPT_CAPTURE_COMMON
         {0, 0, 0, 0 }
     };
@@ -5267,6 +5514,14 @@ main(int argc, char *argv[])
         case 'N':
             pcap_queue_packet_limit = get_positive_int(optarg, "packet_limit");
             break;
+        case LONGOPT_IO_BUFFER_SIZE:
+            io_buffer_size = get_positive_int(optarg, "io buffer size");
+            if (io_buffer_size > MAX_IO_BUFFER_SIZE_KIB) {
+                cmdarg_err("The io buffer size can be at most %d KiB.", MAX_IO_BUFFER_SIZE_KIB);
+                exit_main(1);
+            }
+            io_buffer_size *= 1024;
+            break;
         default:
             cmdarg_err("Invalid Option: %s", argv[optind-1]);
             /* FALLTHROUGH */
@@ -5766,6 +6021,34 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
 }
 
 
+/*
+ * Tell our parent how deep the queue of each capture source is, and how
+ * many packets were dropped because it was full; the values are read
+ * while the capture threads are running, so they're only approximate.
+ */
+static void
+report_queue_stats(void)
+{
+    capture_src *pcap_src;
+    pcap_queue  *queue;
+    guint        i, depth;
+    char         tmp[5 * (SP_DECISIZE + 1) + 1];
+
+    if (!capture_child) {
+        return;
+    }
+
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        queue = &pcap_src->queue;
+        depth = (guint)g_atomic_int_get(&queue->head) - (guint)g_atomic_int_get(&queue->tail);
+        g_snprintf(tmp, sizeof(tmp), "%u:%u:%u:%u:%u", pcap_src->interface_id,
+                   depth, queue->max_depth, queue->size, pcap_src->dropped);
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "Queue: %s", tmp);
+        pipe_write_block(2, SP_QUEUE_STATS, tmp);
+    }
+}
+
 /************************************************************************************************/
 /* signal_pipe handling */
 
@@ -112,6 +112,7 @@ typedef struct _fd_hash_t {
     guint8     digest[16];
     guint32    len;
     nstime_t   frame_time;
+    gboolean   in_set;      /* entry is counted in fd_hash_set */
 } fd_hash_t;
 
 #define DEFAULT_DUP_DEPTH       5   /* Used with -d */
@@ -121,6 +122,14 @@ static fd_hash_t fd_hash[MAX_DUP_DEPTH];
 static int       dup_window    = DEFAULT_DUP_DEPTH;
 static int       cur_dup_entry = 0;
 
+/*
+ * The fd_hash[] entries in the window, keyed by digest and length. The
+ * key is the most recently added entry with that digest and length, and
+ * the value the number of entries in the window that have them, so that
+ * looking for a duplicate doesn't depend on the size of the window.
+ */
+static GHashTable *fd_hash_set = NULL;
+
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
 #define ONE_BILLION 1000000000
@@ -176,6 +185,9 @@ static gboolean               rem_vlan                  = FALSE;
 static gboolean               dup_detect                = FALSE;
 static gboolean               dup_detect_by_time        = FALSE;
 static gboolean               skip_radiotap             = FALSE;
+static gboolean               skip_ip_ttl               = FALSE;
+static guint8                *masked_fd                 = NULL;
+static guint32                masked_size               = 0;
 static gboolean               discard_all_secrets       = FALSE;
 static gboolean               discard_cap_comments      = FALSE;
 
@@ -591,165 +603,280 @@ remove_vlan_info(const wtap_packet_header *phdr, guint8* fd, guint32* len) {
     }
 }
 
+static guint
+fd_hash_hash(gconstpointer key)
+{
+    const fd_hash_t *entry = (const fd_hash_t *)key;
+    guint32 hash;
+
+    /* The digest is already well mixed. */
+    memcpy(&hash, entry->digest, sizeof hash);
+    return hash ^ entry->len;
+}
+
 static gboolean
-is_duplicate(guint8* fd, guint32 len) {
-    int i;
-    const struct ieee80211_radiotap_header* tap_header;
+fd_hash_equal(gconstpointer a, gconstpointer b)
+{
+    const fd_hash_t *entry_a = (const fd_hash_t *)a;
+    const fd_hash_t *entry_b = (const fd_hash_t *)b;
 
-    /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
-    guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
+    return entry_a->len == entry_b->len
+        && memcmp(entry_a->digest, entry_b->digest, 16) == 0;
+}
 
-    if (len <= ignored_bytes) {
-        offset = 0;
+/*
+ * 128-bit MurmurHash3 (x64 variant), by Austin Appleby, who placed it
+ * in the public domain. It's much faster than MD5, and as we only
+ * compare digests of packets from the same file we don't need a
+ * cryptographic hash.
+ */
+static inline guint64
+rotl64(guint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline guint64
+fmix64(guint64 k)
+{
+    k ^= k >> 33;
+    k *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+    k ^= k >> 33;
+    k *= G_GUINT64_CONSTANT(0xc4ceb9fe1a85ec53);
+    k ^= k >> 33;
+    return k;
+}
+
+static void
+murmur3_128(const guint8 *data, guint32 len, guint8 digest[16])
+{
+    const guint64 c1 = G_GUINT64_CONSTANT(0x87c37b91114253d5);
+    const guint64 c2 = G_GUINT64_CONSTANT(0x4cf5ad432745937f);
+    const guint8 *tail = data + (len & ~15U);
+    guint64 h1 = 0, h2 = 0, k1, k2;
+
+    for (; data < tail; data += 16) {
+        /* The digest only needs to be consistent within one run, so
+         * just use host byte order. */
+        memcpy(&k1, data, 8);
+        memcpy(&k2, data + 8, 8);
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
     }
 
-    /* Get the size of radiotap header and use that as offset (-p option) */
-    if (skip_radiotap == TRUE) {
-        tap_header = (const struct ieee80211_radiotap_header*)fd;
-        offset = pletoh16(&tap_header->it_len);
-        if (offset >= len)
+    k1 = 0;
+    k2 = 0;
+    switch (len & 15) {
+        case 15: k2 ^= (guint64)tail[14] << 48; /* FALLTHROUGH */
+        case 14: k2 ^= (guint64)tail[13] << 40; /* FALLTHROUGH */
+        case 13: k2 ^= (guint64)tail[12] << 32; /* FALLTHROUGH */
+        case 12: k2 ^= (guint64)tail[11] << 24; /* FALLTHROUGH */
+        case 11: k2 ^= (guint64)tail[10] << 16; /* FALLTHROUGH */
+        case 10: k2 ^= (guint64)tail[9] << 8;   /* FALLTHROUGH */
+        case  9: k2 ^= (guint64)tail[8];
+                 k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+                 /* FALLTHROUGH */
+        case  8: k1 ^= (guint64)tail[7] << 56;  /* FALLTHROUGH */
+        case  7: k1 ^= (guint64)tail[6] << 48;  /* FALLTHROUGH */
+        case  6: k1 ^= (guint64)tail[5] << 40;  /* FALLTHROUGH */
+        case  5: k1 ^= (guint64)tail[4] << 32;  /* FALLTHROUGH */
+        case  4: k1 ^= (guint64)tail[3] << 24;  /* FALLTHROUGH */
+        case  3: k1 ^= (guint64)tail[2] << 16;  /* FALLTHROUGH */
+        case  2: k1 ^= (guint64)tail[1] << 8;   /* FALLTHROUGH */
+        case  1: k1 ^= (guint64)tail[0];
+                 k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+                 break;
+        default:
+            break;
+    }
+
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    memcpy(digest, &h1, 8);
+    memcpy(digest + 8, &h2, 8);
+}
+
+/*
+ * Return the frame with the IPv4 TTL and header checksum or the IPv6 hop
+ * limit zeroed (--skip-ip-ttl), so that copies of a packet seen on both
+ * sides of a router are duplicates. Returns fd itself if there's no IP
+ * header we know how to find.
+ */
+static const guint8 *
+mask_ip_ttl(const guint8 *fd, guint32 len, int pkt_encap)
+{
+    guint32 offset;
+    guint16 ethertype;
+
+    switch (pkt_encap) {
+        case WTAP_ENCAP_ETHERNET:
+            if (len < 14)
+                return fd;
+            offset = 14;
+            ethertype = pntoh16(fd + 12);
+            while ((ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_IEEE_802_1AD) && len >= offset + 4) {
+                ethertype = pntoh16(fd + offset + 2);
+                offset += 4;
+            }
+            break;
+        case WTAP_ENCAP_SLL:
+            if (len < 16)
+                return fd;
+            offset = 16;
+            ethertype = pntoh16(fd + LINUX_SLL_OFFSETP);
+            break;
+        case WTAP_ENCAP_RAW_IP:
+        case WTAP_ENCAP_RAW_IP4:
+        case WTAP_ENCAP_RAW_IP6:
+            if (len < 1)
+                return fd;
             offset = 0;
+            ethertype = (fd[0] >> 4) == 6 ? ETHERTYPE_IPv6 : ETHERTYPE_IP;
+            break;
+        default:
+            return fd;
+    }
+
+    if (ethertype == ETHERTYPE_IP) {
+        if (len < offset + 20 || (fd[offset] >> 4) != 4)
+            return fd;
+    } else if (ethertype == ETHERTYPE_IPv6) {
+        if (len < offset + 40 || (fd[offset] >> 4) != 6)
+            return fd;
+    } else {
+        return fd;
+    }
+
+    if (masked_size < len) {
+        masked_size = len;
+        masked_fd = (guint8 *)g_realloc(masked_fd, masked_size);
+    }
+    memcpy(masked_fd, fd, len);
+    if (ethertype == ETHERTYPE_IP) {
+        masked_fd[offset + 8] = 0;      /* TTL */
+        masked_fd[offset + 10] = 0;     /* Header checksum */
+        masked_fd[offset + 11] = 0;
+    } else {
+        masked_fd[offset + 7] = 0;      /* Hop limit */
     }
+    return masked_fd;
+}
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
+/*
+ * Replace the oldest entry in the window with the current frame, and return
+ * the most recent other entry with the same length and digest, or NULL if
+ * there's none.
+ */
+static const fd_hash_t *
+add_dup_entry(const guint8* fd, guint32 len, int pkt_encap, guint32 offset, const nstime_t *frame_time) {
+    fd_hash_t *entry;
+    gpointer key, value;
+    guint count;
 
     cur_dup_entry++;
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
+    entry = &fd_hash[cur_dup_entry];
+
+    /* The entry falls out of the window */
+    if (entry->in_set) {
+        if (g_hash_table_lookup_extended(fd_hash_set, entry, &key, &value)) {
+            count = GPOINTER_TO_UINT(value) - 1;
+            if (count == 0)
+                g_hash_table_remove(fd_hash_set, key);
+            else
+                g_hash_table_insert(fd_hash_set, key, GUINT_TO_POINTER(count));
+        }
+        entry->in_set = FALSE;
+    }
 
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
+    if (skip_ip_ttl)
+        fd = mask_ip_ttl(fd, len, pkt_encap);
 
-    fd_hash[cur_dup_entry].len = len;
+    /* Calculate our digest. We print MD5 hashes in verbose mode, as
+     * the documentation promises. */
+    if (verbose)
+        gcry_md_hash_buffer(GCRY_MD_MD5, entry->digest, fd + offset, len - offset);
+    else
+        murmur3_128(fd + offset, len - offset, entry->digest);
 
-    /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
+    entry->len = len;
+    if (frame_time)
+        entry->frame_time = *frame_time;
+    entry->in_set = TRUE;
 
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
-        }
+    /* Look for duplicates */
+    if (g_hash_table_lookup_extended(fd_hash_set, entry, &key, &value)) {
+        /* Make this entry the one the set refers to, so that the key
+         * stays valid until the last entry with this digest falls out
+         * of the window. */
+        g_hash_table_replace(fd_hash_set, entry, GUINT_TO_POINTER(GPOINTER_TO_UINT(value) + 1));
+        return (const fd_hash_t *)key;
     }
-
-    return FALSE;
+    g_hash_table_insert(fd_hash_set, entry, GUINT_TO_POINTER(1));
+    return NULL;
 }
 
 static gboolean
-is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
-    int i;
+is_duplicate(guint8* fd, guint32 len, int pkt_encap) {
+    const struct ieee80211_radiotap_header* tap_header;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
 
     if (len <= ignored_bytes) {
         offset = 0;
     }
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
-
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
-    fd_hash[cur_dup_entry].frame_time.secs = current->secs;
-    fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
-
-    /*
-     * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
-     * We check starting from the most recently added hash
-     * entries and work backwards towards older packets.
-     * This approach allows the dup test to be terminated
-     * when the relative time of a cached entry is found to
-     * be beyond the dup time window.
-     *
-     * Of course this assumes that the input trace file is
-     * "well-formed" in the sense that the packet timestamps are
-     * in strict chronologically increasing order (which is NOT
-     * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
-     */
-
-    for (i = cur_dup_entry - 1;; i--) {
-        nstime_t delta;
-        int cmp;
+    /* Get the size of radiotap header and use that as offset (-p option) */
+    if (skip_radiotap == TRUE) {
+        tap_header = (const struct ieee80211_radiotap_header*)fd;
+        offset = pletoh16(&tap_header->it_len);
+        if (offset >= len)
+            offset = 0;
+    }
 
-        if (i < 0)
-            i = dup_window - 1;
+    return add_dup_entry(fd, len, pkt_encap, offset, NULL) != NULL;
+}
 
-        if (i == cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
-            break;
-        }
+static gboolean
+is_duplicate_rel_time(guint8* fd, guint32 len, int pkt_encap, const nstime_t *current) {
+    const fd_hash_t *prev;
+    nstime_t delta;
 
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
-            break;
-        }
+    /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
+    guint32 offset = ignored_bytes;
 
-        nstime_delta(&delta, current, &fd_hash[i].frame_time);
+    if (len <= ignored_bytes) {
+        offset = 0;
+    }
 
-        if (delta.secs < 0 || delta.nsecs < 0) {
-            /*
-             * A negative delta implies that the current packet
-             * has an absolute timestamp less than the cached packet
-             * that it is being compared to.  This is NOT a normal
-             * situation since trace files usually have packets in
-             * chronological order (oldest to newest).
-             *
-             * There are several possible ways to deal with this:
-             * 1. 'continue' dup checking with the next cached frame.
-             * 2. 'break' from looking for a duplicate of the current frame.
-             * 3. Take the absolute value of the delta and see if that
-             * falls within the specifed dup time window.
-             *
-             * Currently this code does option 1.  But it would pretty
-             * easy to add yet-another-editcap-option to select one of
-             * the other behaviors for dealing with out-of-sequence
-             * packets.
-             */
-            continue;
-        }
+    prev = add_dup_entry(fd, len, pkt_encap, offset, current);
+    if (prev == NULL)
+        return FALSE;
 
-        cmp = nstime_cmp(&delta, &relative_time_window);
+    /*
+     * Only the most recent packet with the same digest matters, as it's
+     * the closest in time if the packets are in chronological order.
+     * That's usually, but NOT always, the case; if the current packet is
+     * older than its most recent copy we don't consider it a duplicate.
+     */
+    nstime_delta(&delta, current, &prev->frame_time);
 
-        if (cmp > 0) {
-            /*
-             * The delta time indicates that we are now looking at
-             * cached packets beyond the specified dup time window.
-             * Check no more!
-             */
-            break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
-        }
-    }
+    if (delta.secs < 0 || delta.nsecs < 0)
+        return FALSE;
 
-    return FALSE;
+    return nstime_cmp(&delta, &relative_time_window) <= 0;
 }
 
 static void
@@ -789,6 +916,10 @@ print_usage(FILE *output)
     fprintf(output, "  --skip-radiotap-header skip radiotap header when checking for packet duplicates.\n");
     fprintf(output, "                         Useful when processing packets captured by multiple radios\n");
     fprintf(output, "                         on the same channel in the vicinity of each other.\n");
+    fprintf(output, "  --skip-ip-ttl          ignore the IPv4 TTL and header checksum and the IPv6\n");
+    fprintf(output, "                         hop limit when checking for packet duplicates.\n");
+    fprintf(output, "                         Useful when the same packets were captured on both\n");
+    fprintf(output, "                         sides of a router.\n");
     fprintf(output, "\n");
     fprintf(output, "Packet manipulation:\n");
     fprintf(output, "  -s <snaplen>           truncate each packet to max. <snaplen> bytes of data.\n");
@@ -822,7 +953,7 @@ print_usage(FILE *output)
     fprintf(output, "                         the pseudo-random number generator. This allows one to\n");
     fprintf(output, "                         repeat a particular sequence of errors.\n");
     fprintf(output, "  -I <bytes to ignore>   ignore the specified number of bytes at the beginning\n");
-    fprintf(output, "                         of the frame during MD5 hash calculation, unless the\n");
+    fprintf(output, "                         of the frame during hash calculation, unless the\n");
     fprintf(output, "                         frame is too short, then the full frame is used.\n");
     fprintf(output, "                         Useful to remove duplicated packets taken on\n");
     fprintf(output, "                         several routers (different mac addresses for\n");
@@ -1095,10 +1226,12 @@ main(int argc, char *argv[])
 #define LONGOPT_DISCARD_ALL_SECRETS  LONGOPT_BASE_APPLICATION+5
 #define LONGOPT_CAPTURE_COMMENT      LONGOPT_BASE_APPLICATION+6
 #define LONGOPT_DISCARD_CAPTURE_COMMENT LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_SKIP_IP_TTL          LONGOPT_BASE_APPLICATION+8
 
     static const struct option long_options[] = {
         {"novlan", no_argument, NULL, LONGOPT_NO_VLAN},
         {"skip-radiotap-header", no_argument, NULL, LONGOPT_SKIP_RADIOTAP_HEADER},
+        {"skip-ip-ttl", no_argument, NULL, LONGOPT_SKIP_IP_TTL},
         {"seed", required_argument, NULL, LONGOPT_SEED},
         {"inject-secrets", required_argument, NULL, LONGOPT_INJECT_SECRETS},
         {"discard-all-secrets", no_argument, NULL, LONGOPT_DISCARD_ALL_SECRETS},
@@ -1192,6 +1325,12 @@ main(int argc, char *argv[])
             break;
         }
 
+        case LONGOPT_SKIP_IP_TTL:
+        {
+            skip_ip_ttl = TRUE;
+            break;
+        }
+
         case LONGOPT_SEED:
         {
             if (sscanf(optarg, "%u", &seed) != 1) {
@@ -1688,7 +1827,9 @@ main(int argc, char *argv[])
             memset(&fd_hash[i].digest, 0, 16);
             fd_hash[i].len = 0;
             nstime_set_unset(&fd_hash[i].frame_time);
+            fd_hash[i].in_set = FALSE;
         }
+        fd_hash_set = g_hash_table_new(fd_hash_hash, fd_hash_equal);
     }
 
     /* Set up an array of all IDBs seen */
@@ -2004,7 +2145,8 @@ main(int argc, char *argv[])
 
                 /* suppress duplicates by packet window */
                 if (dup_detect) {
-                    if (is_duplicate(buf, rec->rec_header.packet_header.caplen)) {
+                    if (is_duplicate(buf, rec->rec_header.packet_header.caplen,
+                                     rec->rec_header.packet_header.pkt_encap)) {
                         if (verbose) {
                             fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
                                     count,
@@ -2040,6 +2182,7 @@ main(int argc, char *argv[])
 
                         if (is_duplicate_rel_time(buf,
                                                   rec->rec_header.packet_header.caplen,
+                                                  rec->rec_header.packet_header.pkt_encap,
                                                   &current)) {
                             if (verbose) {
                                 fprintf(stderr, "Skipped: %u, Len: %u, MD5 Hash: ",
@@ -2269,6 +2412,9 @@ clean_exit:
         }
         g_array_free(idbs_seen, TRUE);
     }
+    if (fd_hash_set != NULL)
+        g_hash_table_destroy(fd_hash_set);
+    g_free(masked_fd);
     g_free(params.idb_inf);
     wtap_dump_params_cleanup(&params);
     if (wth != NULL)
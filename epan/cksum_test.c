@@ -0,0 +1,191 @@
+/* cksum_test.c
+ * Standalone program to test, and time, the Internet checksum and CRC-32C
+ * routines against simple reference implementations.
+ *
+ * Run with "-m perf" to also time them:
+ *
+ *      ./cksum_test -m perf --verbose
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <epan/in_cksum.h>
+#include <wsutil/crc32.h>
+
+#define BUF_SIZE        65536
+#define PERF_ITERS      2000
+
+static guint8 *test_buf;
+
+/* RFC 1071-style checksum, a byte pair at a time. */
+static guint16
+ref_in_cksum(const guint8 *p, int len)
+{
+	guint32 sum = 0;
+	int i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += (p[i] << 8) | p[i + 1];
+	if (len & 1)
+		sum += p[len - 1] << 8;
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return g_htons(~sum & 0xffff);
+}
+
+/* CRC-32C a byte at a time, with the same table crc32.c uses. */
+static guint32
+ref_crc32c(const guint8 *p, int len, guint32 crc)
+{
+	crc = CRC32C_SWAP(crc);
+	while (len-- > 0)
+		crc = (crc >> 8) ^ crc32c_table_lookup((guchar)(crc ^ *p++));
+	return CRC32C_SWAP(crc);
+}
+
+static void
+test_in_cksum(void)
+{
+	int offset, len;
+
+	/* All alignments, and lengths around the unrolled loop's sizes */
+	for (offset = 0; offset < 8; offset++) {
+		for (len = 0; len < 200; len++) {
+			g_assert_cmpuint(ip_checksum(test_buf + offset, len), ==,
+			    ref_in_cksum(test_buf + offset, len));
+		}
+	}
+
+	g_assert_cmpuint(ip_checksum(test_buf, BUF_SIZE), ==,
+	    ref_in_cksum(test_buf, BUF_SIZE));
+	g_assert_cmpuint(ip_checksum(test_buf + 1, BUF_SIZE - 1), ==,
+	    ref_in_cksum(test_buf + 1, BUF_SIZE - 1));
+}
+
+static void
+test_in_cksum_vec(void)
+{
+	vec_t vec[3];
+	int split1, split2;
+	const int len = 150;
+
+	/* Data split into pieces of odd and even lengths */
+	for (split1 = 0; split1 <= len; split1 += 7) {
+		for (split2 = split1; split2 <= len; split2 += 5) {
+			SET_CKSUM_VEC_PTR(vec[0], test_buf, split1);
+			SET_CKSUM_VEC_PTR(vec[1], test_buf + split1, split2 - split1);
+			SET_CKSUM_VEC_PTR(vec[2], test_buf + split2, len - split2);
+			g_assert_cmpuint(in_cksum(vec, 3), ==, ref_in_cksum(test_buf, len));
+		}
+	}
+}
+
+static void
+test_crc32c(void)
+{
+	int offset, len;
+
+	for (offset = 0; offset < 8; offset++) {
+		for (len = 0; len < 100; len++) {
+			g_assert_cmpuint(crc32c_calculate(test_buf + offset, len, CRC32C_PRELOAD), ==,
+			    ref_crc32c(test_buf + offset, len, CRC32C_PRELOAD));
+		}
+	}
+
+	g_assert_cmpuint(crc32c_calculate(test_buf, BUF_SIZE, CRC32C_PRELOAD), ==,
+	    ref_crc32c(test_buf, BUF_SIZE, CRC32C_PRELOAD));
+
+	/* The check value from the CRC catalogue */
+	g_assert_cmpuint(~CRC32C_SWAP(crc32c_calculate("123456789", 9, CRC32C_PRELOAD)), ==, 0xe3069283);
+}
+
+static void
+perf_report(const char *what, double seconds)
+{
+	double mbytes = (double)BUF_SIZE * PERF_ITERS / (1024 * 1024);
+
+	g_test_maximized_result(mbytes / seconds, "%s: %.1f MB/s", what, mbytes / seconds);
+}
+
+static void
+perf_in_cksum(void)
+{
+	volatile guint16 result = 0;
+	int i;
+
+	g_test_timer_start();
+	for (i = 0; i < PERF_ITERS; i++)
+		result ^= ip_checksum(test_buf, BUF_SIZE);
+	perf_report("ip_checksum", g_test_timer_elapsed());
+
+	g_test_timer_start();
+	for (i = 0; i < PERF_ITERS; i++)
+		result ^= ref_in_cksum(test_buf, BUF_SIZE);
+	perf_report("reference checksum", g_test_timer_elapsed());
+}
+
+static void
+perf_crc32c(void)
+{
+	volatile guint32 result = 0;
+	int i;
+
+	g_test_timer_start();
+	for (i = 0; i < PERF_ITERS; i++)
+		result ^= crc32c_calculate(test_buf, BUF_SIZE, CRC32C_PRELOAD);
+	perf_report("crc32c_calculate", g_test_timer_elapsed());
+
+	g_test_timer_start();
+	for (i = 0; i < PERF_ITERS; i++)
+		result ^= ref_crc32c(test_buf, BUF_SIZE, CRC32C_PRELOAD);
+	perf_report("table-driven crc32c", g_test_timer_elapsed());
+}
+
+int
+main(int argc, char **argv)
+{
+	int ret;
+	int i;
+
+	g_test_init(&argc, &argv, NULL);
+
+	test_buf = (guint8 *)g_malloc(BUF_SIZE);
+	for (i = 0; i < BUF_SIZE; i++)
+		test_buf[i] = (guint8)g_test_rand_int();
+
+	g_test_add_func("/cksum/in_cksum", test_in_cksum);
+	g_test_add_func("/cksum/in_cksum_vec", test_in_cksum_vec);
+	g_test_add_func("/cksum/crc32c", test_crc32c);
+
+	if (g_test_perf()) {
+		g_test_add_func("/cksum/perf/in_cksum", perf_in_cksum);
+		g_test_add_func("/cksum/perf/crc32c", perf_crc32c);
+	}
+
+	ret = g_test_run();
+
+	g_free(test_buf);
+
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -40,6 +40,8 @@ struct conversation_key {
 	endpoint_type etype;
 	guint32	port1;
 	guint32	port2;
+	guint	addr1_hash;	/* add_address_to_hash() of addr1 */
+	guint	addr2_hash;	/* add_address_to_hash() of addr2 */
 };
 
 /*
@@ -168,32 +170,24 @@ conversation_create_from_template(conversation_t *conversation, const address *a
 }
 
 /*
- * Compute the hash value for two given address/port pairs if the match
- * is to be exact.
- */
-/* http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
- * One-at-a-Time hash
+ * The addresses in a key are hashed once, when the key is set up, and
+ * the per-table hash functions below just mix those hashes with the
+ * ports, so that trying several tables, or both directions, for a
+ * lookup doesn't hash the address data over and over again.
  */
-guint
-conversation_hash_exact(gconstpointer v)
+static inline guint
+conversation_hash_mix(guint hash_val, guint32 val)
 {
-	const conversation_key_t key = (const conversation_key_t)v;
-	guint hash_val;
-	address tmp_addr;
-
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
+	hash_val ^= val;
+	hash_val *= 0x9E3779B1;
+	hash_val ^= ( hash_val >> 15 );
 
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
-
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	return hash_val;
+}
 
+static inline guint
+conversation_hash_finish(guint hash_val)
+{
 	hash_val += ( hash_val << 3 );
 	hash_val ^= ( hash_val >> 11 );
 	hash_val += ( hash_val << 15 );
@@ -201,6 +195,31 @@ conversation_hash_exact(gconstpointer v)
 	return hash_val;
 }
 
+static inline void
+conversation_key_hash_addresses(struct conversation_key *key)
+{
+	key->addr1_hash = add_address_to_hash(0, &key->addr1);
+	key->addr2_hash = add_address_to_hash(0, &key->addr2);
+}
+
+/*
+ * Compute the hash value for two given address/port pairs if the match
+ * is to be exact.
+ *
+ * conversation_match_exact() matches the key in either direction, so
+ * the two endpoints are combined symmetrically; that way a packet going
+ * in either direction finds the conversation with a single lookup.
+ */
+guint
+conversation_hash_exact(gconstpointer v)
+{
+	const conversation_key_t key = (const conversation_key_t)v;
+
+	return conversation_hash_finish(
+	    conversation_hash_mix(key->addr1_hash, key->port1) +
+	    conversation_hash_mix(key->addr2_hash, key->port2));
+}
+
 /*
  * Compare two conversation keys for an exact match.
  */
@@ -262,24 +281,11 @@ conversation_hash_no_addr2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
+	hash_val = conversation_hash_mix(key->addr1_hash, key->port1);
+	hash_val = conversation_hash_mix(hash_val, key->port2);
 
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -327,23 +333,11 @@ conversation_hash_no_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
-
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
 
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
+	hash_val = conversation_hash_mix(key->addr1_hash, key->port1);
+	hash_val = conversation_hash_mix(hash_val, key->addr2_hash);
 
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -390,22 +384,8 @@ static guint
 conversation_hash_no_addr2_or_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
-	guint hash_val;
-	address tmp_addr;
-
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
 
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(conversation_hash_mix(key->addr1_hash, key->port1));
 }
 
 /*
@@ -737,6 +717,7 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 	new_key->etype = etype;
 	new_key->port1 = port1;
 	new_key->port2 = port2;
+	conversation_key_hash_addresses(new_key);
 
 	conversation = wmem_new0(wmem_file_scope(), conversation_t);
 
@@ -828,6 +809,7 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
 	}
 	conv->options &= ~NO_ADDR2;
 	copy_address_wmem(wmem_file_scope(), &conv->key_ptr->addr2, addr);
+	conv->key_ptr->addr2_hash = add_address_to_hash(0, addr);
 	if (conv->options & NO_PORT2) {
 		conversation_insert_into_hashtable(conversation_hashtable_no_port2, conv);
 	} else {
@@ -837,37 +819,61 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
 }
 
 /*
- * Search a particular hash table for a conversation with the specified
- * {addr1, port1, addr2, port2} and set up before frame_num.
+ * Set up a key for looking up {addr1, port1, addr2, port2}.
+ *
+ * We don't make a copy of the address data, we just copy the
+ * pointer to it, so the key must not outlive the addresses.
  */
-static conversation_t *
-conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, const address *addr1, const address *addr2,
+static void
+conversation_lookup_key_init(struct conversation_key *key, const address *addr1, const address *addr2,
     const endpoint_type etype, const guint32 port1, const guint32 port2)
 {
-	conversation_t* convo=NULL;
-	conversation_t* match=NULL;
-	conversation_t* chain_head=NULL;
-	struct conversation_key key;
-
-	/*
-	 * We don't make a copy of the address data, we just copy the
-	 * pointer to it, as "key" disappears when we return.
-	 */
 	if (addr1 != NULL) {
-		key.addr1 = *addr1;
+		key->addr1 = *addr1;
 	} else {
-		clear_address(&key.addr1);
+		clear_address(&key->addr1);
 	}
 	if (addr2 != NULL) {
-		key.addr2 = *addr2;
+		key->addr2 = *addr2;
 	} else {
-		clear_address(&key.addr2);
+		clear_address(&key->addr2);
 	}
-	key.etype = etype;
-	key.port1 = port1;
-	key.port2 = port2;
+	key->etype = etype;
+	key->port1 = port1;
+	key->port2 = port2;
+	conversation_key_hash_addresses(key);
+}
+
+/*
+ * Set up a lookup key with the addresses of another one swapped and,
+ * if swap_ports is set, the ports swapped as well, reusing its address
+ * hashes.
+ */
+static void
+conversation_lookup_key_reverse(struct conversation_key *key, const struct conversation_key *from,
+    gboolean swap_ports)
+{
+	key->addr1 = from->addr2;
+	key->addr2 = from->addr1;
+	key->addr1_hash = from->addr2_hash;
+	key->addr2_hash = from->addr1_hash;
+	key->etype = from->etype;
+	key->port1 = swap_ports ? from->port2 : from->port1;
+	key->port2 = swap_ports ? from->port1 : from->port2;
+}
+
+/*
+ * Search a particular hash table for a conversation with the specified
+ * key and set up before frame_num.
+ */
+static conversation_t *
+conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, const struct conversation_key *key)
+{
+	conversation_t* convo=NULL;
+	conversation_t* match=NULL;
+	conversation_t* chain_head=NULL;
 
-	chain_head = (conversation_t *)wmem_map_lookup(hashtable, &key);
+	chain_head = (conversation_t *)wmem_map_lookup(hashtable, key);
 
 	if (chain_head && (chain_head->setup_frame <= frame_num)) {
 		match = chain_head;
@@ -933,6 +939,16 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
     const guint32 port_a, const guint32 port_b, const guint options)
 {
 	conversation_t *conversation;
+	struct conversation_key key_ab, key_ba, key_fc;
+
+	/*
+	 * Set up the keys for each direction once; the address hashes
+	 * are shared by all of the lookups below.
+	 */
+	conversation_lookup_key_init(&key_ab, addr_a, addr_b, etype, port_a, port_b);
+	conversation_lookup_key_reverse(&key_ba, &key_ab, TRUE);
+	/* In Fibre channel, OXID & RXID are never swapped as TCP/UDP ports are */
+	conversation_lookup_key_reverse(&key_fc, &key_ab, FALSE);
 
 	DINSTR(gchar *addr_a_str = address_to_str(NULL, addr_a));
 	DINSTR(gchar *addr_b_str = address_to_str(NULL, addr_b));
@@ -946,19 +962,14 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		 */
 		DPRINT(("trying exact match: %s:%d -> %s:%d",
 		    addr_a_str, port_a, addr_b_str, port_b));
+		/*
+		 * This also finds a conversation set up in the other
+		 * direction, as the exact match hash and comparison
+		 * functions don't care about the direction.
+		 */
 		conversation =
 		    conversation_lookup_hashtable(conversation_hashtable_exact,
-			frame_num, addr_a, addr_b, etype,
-			port_a, port_b);
-		/* Didn't work, try the other direction */
-		if (conversation == NULL) {
-			DPRINT(("trying exact match: %s:%d -> %s:%d",
-			    addr_b_str, port_b, addr_a_str, port_a));
-			conversation =
-			    conversation_lookup_hashtable(conversation_hashtable_exact,
-				frame_num, addr_b, addr_a, etype,
-				port_b, port_a);
-		}
+			frame_num, &key_ab);
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP.
@@ -967,8 +978,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_a, addr_a_str, port_b));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_exact,
-				frame_num, addr_b, addr_a, etype,
-				port_a, port_b);
+				frame_num, &key_fc);
 		}
 		DPRINT(("exact match %sfound",conversation?"":"not "));
 		if (conversation != NULL)
@@ -993,7 +1003,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		    addr_a_str, port_a, port_b));
 		conversation =
 		    conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-			frame_num, addr_a, addr_b, etype, port_a, port_b);
+			frame_num, &key_ab);
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP.
@@ -1002,8 +1012,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_a, port_b));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-				frame_num, addr_b, addr_a, etype,
-				port_a, port_b);
+				frame_num, &key_fc);
 		}
 		if (conversation != NULL) {
 			/*
@@ -1048,7 +1057,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_b, port_a));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, &key_ba);
 			if (conversation != NULL) {
 				/*
 				 * If this is for a connection-oriented
@@ -1093,7 +1102,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		    addr_a_str, port_a, addr_b_str));
 		conversation =
 		    conversation_lookup_hashtable(conversation_hashtable_no_port2,
-			frame_num, addr_a, addr_b, etype, port_a, port_b);
+			frame_num, &key_ab);
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP
@@ -1101,7 +1110,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			DPRINT(("trying wildcarded match: %s:%d -> %s:*", addr_b_str, port_a, addr_a_str));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_port2,
-				frame_num, addr_b, addr_a, etype, port_a, port_b);
+				frame_num, &key_fc);
 		}
 		if (conversation != NULL) {
 			/*
@@ -1146,7 +1155,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_b, addr_a_str));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_port2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, &key_ba);
 			if (conversation != NULL) {
 				/*
 				 * If this is for a connection-oriented
@@ -1185,7 +1194,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 	DPRINT(("trying wildcarded match: %s:%d -> *:*", addr_a_str, port_a));
 	conversation =
 	    conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-		frame_num, addr_a, addr_b, etype, port_a, port_b);
+		frame_num, &key_ab);
 	if (conversation != NULL) {
 		/*
 		 * If this is for a connection-oriented protocol:
@@ -1240,13 +1249,13 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_a));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-				frame_num, addr_b, addr_a, etype, port_a, port_b);
+				frame_num, &key_fc);
 		} else {
 			DPRINT(("trying wildcarded match: %s:%d -> *:*",
 			    addr_b_str, port_b));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, &key_ba);
 		}
 		if (conversation != NULL) {
 			/*
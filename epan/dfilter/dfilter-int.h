@@ -19,6 +19,8 @@
 struct epan_dfilter {
 	GPtrArray	*insns;
 	GPtrArray	*consts;
+	struct _dfvm_code *code;
+	guint		code_len;
 	guint		num_registers;
 	guint		max_registers;
 	GList		**registers;
@@ -131,6 +131,7 @@ dfilter_free(dfilter_t *df)
 		free_insns(df->consts);
 	}
 
+	g_free(df->code);
 	g_free(df->interesting_fields);
 
 	/* Clear registers with constant values (as set by dfvm_init_const).
@@ -356,6 +357,9 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		/* Initialize constants */
 		dfvm_init_const(dfilter);
 
+		/* Lay the instructions out for running */
+		dfvm_link(dfilter);
+
 		/* Add any deprecated items */
 		dfilter->deprecated = deprecated;
 
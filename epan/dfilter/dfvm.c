@@ -463,29 +463,23 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 {
 	int		id, length;
 	gboolean	accum = TRUE;
-	dfvm_insn_t	*insn;
-	dfvm_value_t	*arg1;
-	dfvm_value_t	*arg2;
-	dfvm_value_t	*arg3 = NULL;
-	dfvm_value_t	*arg4 = NULL;
+	const dfvm_code_t	*code;
 	header_field_info	*hfinfo;
 	GList		*param1;
 	GList		*param2;
 
 	g_assert(tree);
 
-	length = df->insns->len;
+	length = df->code_len;
 
 	for (id = 0; id < length; id++) {
 
 	  AGAIN:
-		insn = (dfvm_insn_t	*)g_ptr_array_index(df->insns, id);
-		arg1 = insn->arg1;
-		arg2 = insn->arg2;
+		code = &df->code[id];
 
-		switch (insn->op) {
+		switch (code->op) {
 			case CHECK_EXISTS:
-				hfinfo = arg1->value.hfinfo;
+				hfinfo = code->arg1.value.hfinfo;
 				while(hfinfo) {
 					accum = proto_check_for_protocol_or_field(tree,
 							hfinfo->id);
@@ -500,83 +494,79 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case READ_TREE:
 				accum = read_tree(df, tree,
-						arg1->value.hfinfo, arg2->value.numeric);
+						code->arg1.value.hfinfo, code->arg2.value.numeric);
 				break;
 
 			case CALL_FUNCTION:
-				arg3 = insn->arg3;
-				arg4 = insn->arg4;
 				param1 = NULL;
 				param2 = NULL;
-				if (arg3) {
-					param1 = df->registers[arg3->value.numeric];
+				if (code->arg3.type != EMPTY) {
+					param1 = df->registers[code->arg3.value.numeric];
 				}
-				if (arg4) {
-					param2 = df->registers[arg4->value.numeric];
+				if (code->arg4.type != EMPTY) {
+					param2 = df->registers[code->arg4.value.numeric];
 				}
-				accum = arg1->value.funcdef->function(param1, param2,
-						&df->registers[arg2->value.numeric]);
+				accum = code->arg1.value.funcdef->function(param1, param2,
+						&df->registers[code->arg2.value.numeric]);
 				// functions create a new value, so own it.
-				df->owns_memory[arg2->value.numeric] = TRUE;
+				df->owns_memory[code->arg2.value.numeric] = TRUE;
 				break;
 
 			case MK_RANGE:
-				arg3 = insn->arg3;
 				mk_range(df,
-						arg1->value.numeric, arg2->value.numeric,
-						arg3->value.drange);
+						code->arg1.value.numeric, code->arg2.value.numeric,
+						code->arg3.value.drange);
 				break;
 
 			case ANY_EQ:
 				accum = any_test(df, fvalue_eq,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_NE:
 				accum = any_test(df, fvalue_ne,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_GT:
 				accum = any_test(df, fvalue_gt,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_GE:
 				accum = any_test(df, fvalue_ge,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_LT:
 				accum = any_test(df, fvalue_lt,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_LE:
 				accum = any_test(df, fvalue_le,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_BITWISE_AND:
 				accum = any_test(df, fvalue_bitwise_and,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_CONTAINS:
 				accum = any_test(df, fvalue_contains,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_MATCHES:
 				accum = any_test(df, fvalue_matches,
-						arg1->value.numeric, arg2->value.numeric);
+						code->arg1.value.numeric, code->arg2.value.numeric);
 				break;
 
 			case ANY_IN_RANGE:
-				arg3 = insn->arg3;
-				accum = any_in_range(df, arg1->value.numeric,
-						arg2->value.numeric,
-						arg3->value.numeric);
+				accum = any_in_range(df, code->arg1.value.numeric,
+						code->arg2.value.numeric,
+						code->arg3.value.numeric);
 				break;
 
 			case NOT:
@@ -589,26 +579,20 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case IF_TRUE_GOTO:
 				if (accum) {
-					id = arg1->value.numeric;
+					id = code->arg1.value.numeric;
 					goto AGAIN;
 				}
 				break;
 
 			case IF_FALSE_GOTO:
 				if (!accum) {
-					id = arg1->value.numeric;
+					id = code->arg1.value.numeric;
 					goto AGAIN;
 				}
 				break;
 
 			case PUT_FVALUE:
-#if 0
 				/* These were handled in the constants initialization */
-				accum = put_fvalue(df,
-						arg1->value.fvalue, arg2->value.numeric);
-				break;
-#endif
-
 			default:
 				g_assert_not_reached();
 				break;
@@ -667,6 +651,42 @@ dfvm_init_const(dfilter_t *df)
 	return;
 }
 
+static void
+link_value(dfvm_value_t *to, const dfvm_value_t *from)
+{
+	if (from) {
+		*to = *from;
+	}
+	else {
+		to->type = EMPTY;
+	}
+}
+
+/* Lays the instructions out in one flat array, with their arguments
+ * inline, so that running the filter walks contiguous memory instead of
+ * following a pointer to each instruction and to each of its arguments. */
+void
+dfvm_link(dfilter_t *df)
+{
+	guint		id;
+	dfvm_insn_t	*insn;
+	dfvm_code_t	*code;
+
+	df->code_len = df->insns->len;
+	df->code = g_new(dfvm_code_t, df->code_len);
+
+	for (id = 0; id < df->code_len; id++) {
+		insn = (dfvm_insn_t	*)g_ptr_array_index(df->insns, id);
+		code = &df->code[id];
+
+		code->op = insn->op;
+		link_value(&code->arg1, insn->arg1);
+		link_value(&code->arg2, insn->arg2);
+		link_value(&code->arg3, insn->arg3);
+		link_value(&code->arg4, insn->arg4);
+	}
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
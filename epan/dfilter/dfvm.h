@@ -73,6 +73,18 @@ typedef struct {
 	dfvm_value_t	*arg4;
 } dfvm_insn_t;
 
+/* Flat form of an instruction, with its arguments stored inline, that
+ * dfvm_apply() runs. The values are shallow copies; anything they point
+ * to is still owned by the dfvm_insn_t they were linked from. Missing
+ * arguments have the type EMPTY. */
+typedef struct _dfvm_code {
+	dfvm_opcode_t	op;
+	dfvm_value_t	arg1;
+	dfvm_value_t	arg2;
+	dfvm_value_t	arg3;
+	dfvm_value_t	arg4;
+} dfvm_code_t;
+
 dfvm_insn_t*
 dfvm_insn_new(dfvm_opcode_t op);
 
@@ -91,4 +103,7 @@ dfvm_apply(dfilter_t *df, proto_tree *tree);
 void
 dfvm_init_const(dfilter_t *df);
 
+void
+dfvm_link(dfilter_t *df);
+
 #endif
@@ -1935,12 +1935,95 @@ tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean c
 }
 
 
+/* Add a segment to a flow's list of unacked segments, keeping the list
+ * sorted by sequence number.  New segments almost always go at the end of
+ * the list, and retransmissions usually near its start, so look for the
+ * place to insert the segment from whichever end is closer.
+ */
+static void
+tcp_unacked_insert(tcp_analyze_seq_flow_info_t *info, tcp_unacked_t *ual)
+{
+    tcp_unacked_t *next;
+
+    if (!info->segments) {
+        ual->next = ual->prev = NULL;
+        info->segments = info->segments_last = ual;
+        info->segments_nextseq = ual->nextseq;
+        info->segment_count++;
+        return;
+    }
+
+    if ((gint32)(ual->seq - info->segments->seq) < (gint32)(info->segments_last->seq - ual->seq)) {
+        for (next = info->segments; next && LE_SEQ(next->seq, ual->seq); next = next->next)
+            ;
+    } else {
+        tcp_unacked_t *prev;
+
+        for (prev = info->segments_last; prev && GT_SEQ(prev->seq, ual->seq); prev = prev->prev)
+            ;
+        next = prev ? prev->next : info->segments;
+    }
+
+    ual->next = next;
+    ual->prev = next ? next->prev : info->segments_last;
+    if (ual->prev) {
+        ual->prev->next = ual;
+    } else {
+        info->segments = ual;
+    }
+    if (next) {
+        next->prev = ual;
+    } else {
+        info->segments_last = ual;
+    }
+    if (GT_SEQ(ual->nextseq, info->segments_nextseq)) {
+        info->segments_nextseq = ual->nextseq;
+    }
+    info->segment_count++;
+}
+
+static void
+tcp_unacked_remove(tcp_analyze_seq_flow_info_t *info, tcp_unacked_t *ual)
+{
+    if (ual->prev) {
+        ual->prev->next = ual->next;
+    } else {
+        info->segments = ual->next;
+    }
+    if (ual->next) {
+        ual->next->prev = ual->prev;
+    } else {
+        info->segments_last = ual->prev;
+    }
+    wmem_free(wmem_file_scope(), ual);
+    info->segment_count--;
+}
+
+/* Once a flow has too many unacked segments (e.g., we're not seeing the
+ * ACKs), fold the two with the lowest sequence numbers into one range so
+ * that newer segments can still be tracked.  The range no longer refers to
+ * a single frame, so ACKs of it aren't matched to one.
+ */
+static void
+tcp_unacked_summarize(tcp_analyze_seq_flow_info_t *info)
+{
+    tcp_unacked_t *first = info->segments;
+    tcp_unacked_t *second = first->next;
+
+    if (GT_SEQ(second->nextseq, first->nextseq)) {
+        first->nextseq = second->nextseq;
+    }
+    first->frame = 0;
+    tcp_unacked_remove(info, second);
+}
+
 /* fwd contains a list of all segments processed but not yet ACKed in the
  *     same direction as the current segment.
  * rev contains a list of all segments received but not yet ACKed in the
  *     opposite direction to the current segment.
  *
- * New segments are always added to the head of the fwd/rev lists.
+ * Both lists are sorted by sequence number, so that an ACK only has to
+ * look at the segments it acknowledges.
  *
  * Changes below should be synced with ChAdvTCPAnalysis in the User's
  * Guide: docbook/wsug_src/WSUG_chapter_advanced.adoc
@@ -1949,9 +2032,9 @@ static void
 tcp_analyze_sequence_number(packet_info *pinfo, guint32 seq, guint32 ack, guint32 seglen, guint16 flags, guint32 window, struct tcp_analysis *tcpd)
 {
     tcp_unacked_t *ual=NULL;
-    tcp_unacked_t *prevual=NULL;
     guint32 nextseq;
-    int ackcount;
+    guint32 acked_frame;
+    nstime_t acked_ts;
 
 #if 0
     printf("\nanalyze_sequence numbers   frame:%u\n",pinfo->num);
@@ -2304,14 +2387,14 @@ finished_fwd:
 finished_checking_retransmission_type:
 
     nextseq = seq+seglen;
-    if ((seglen || flags&(TH_SYN|TH_FIN)) && tcpd->fwd->tcp_analyze_seq_info->segment_count < TCP_MAX_UNACKED_SEGMENTS) {
-        /* Add this new sequence number to the fwd list.  But only if there
-         * aren't "too many" unacked segments (e.g., we're not seeing the ACKs).
+    if (seglen || flags&(TH_SYN|TH_FIN)) {
+        /* Add this new sequence number to the fwd list, making room for it
+         * if there are "too many" unacked segments.
          */
+        if (tcpd->fwd->tcp_analyze_seq_info->segment_count >= TCP_MAX_UNACKED_SEGMENTS) {
+            tcp_unacked_summarize(tcpd->fwd->tcp_analyze_seq_info);
+        }
         ual = wmem_new(wmem_file_scope(), tcp_unacked_t);
-        ual->next=tcpd->fwd->tcp_analyze_seq_info->segments;
-        tcpd->fwd->tcp_analyze_seq_info->segments=ual;
-        tcpd->fwd->tcp_analyze_seq_info->segment_count++;
         ual->frame=pinfo->num;
         ual->seq=seq;
         ual->ts=pinfo->abs_ts;
@@ -2321,6 +2404,7 @@ finished_checking_retransmission_type:
             nextseq+=1;
         }
         ual->nextseq=nextseq;
+        tcp_unacked_insert(tcpd->fwd->tcp_analyze_seq_info, ual);
     }
 
     /* Store the highest number seen so far for nextseq so we can detect
@@ -2368,36 +2452,32 @@ finished_checking_retransmission_type:
     }
 
 
-    /* remove all segments this ACKs and we don't need to keep around any more
+    /* remove all segments this ACKs and we don't need to keep around any more.
+     * Only the segments that start before the ACK are affected, and they are
+     * at the start of the list.
      */
-    ackcount=0;
-    prevual = NULL;
+    acked_frame = 0;
+    nstime_set_zero(&acked_ts);
     ual = tcpd->rev->tcp_analyze_seq_info->segments;
-    while(ual) {
-        tcp_unacked_t *tmpual;
+    while(ual && GT_SEQ(ack, ual->seq)) {
+        tcp_unacked_t *tmpual = ual->next;
 
-        /* If this ack matches the segment, process accordingly */
-        if(ack==ual->nextseq) {
-            tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
-            tcpd->ta->frame_acked=ual->frame;
-            nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &ual->ts);
-        }
         /* If this acknowledges part of the segment, adjust the segment info for the acked part */
-        else if (GT_SEQ(ack, ual->seq) && LE_SEQ(ack, ual->nextseq)) {
+        if (LT_SEQ(ack, ual->nextseq)) {
             ual->seq = ack;
+            ual = tmpual;
             continue;
         }
-        /* If this acknowledges a segment prior to this one, leave this segment alone and move on */
-        else if (GT_SEQ(ual->nextseq,ack)) {
-            prevual = ual;
-            ual = ual->next;
-            continue;
+
+        /* If this ack matches the segment, process accordingly.  If it
+         * matches several, the first one sent is the one acked.
+         */
+        if (ack == ual->nextseq && ual->frame && (!acked_frame || ual->frame < acked_frame)) {
+            acked_frame = ual->frame;
+            acked_ts = ual->ts;
         }
 
         /* This segment is old, or an exact match.  Delete the segment from the list */
-        ackcount++;
-        tmpual=ual->next;
-
         if (tcpd->rev->scps_capable) {
           /* Track largest segment successfully sent for SNACK analysis*/
           if ((ual->nextseq - ual->seq) > tcpd->fwd->maxsizeacked) {
@@ -2405,15 +2485,13 @@ finished_checking_retransmission_type:
           }
         }
 
-        if (!prevual) {
-            tcpd->rev->tcp_analyze_seq_info->segments = tmpual;
-        }
-        else{
-            prevual->next = tmpual;
-        }
-        wmem_free(wmem_file_scope(), ual);
+        tcp_unacked_remove(tcpd->rev->tcp_analyze_seq_info, ual);
         ual = tmpual;
-        tcpd->rev->tcp_analyze_seq_info->segment_count--;
+    }
+    if (acked_frame) {
+        tcp_analyze_get_acked_struct(pinfo->num, seq, ack, TRUE, tcpd);
+        tcpd->ta->frame_acked=acked_frame;
+        nstime_delta(&tcpd->ta->ts, &pinfo->abs_ts, &acked_ts);
     }
 
     /* how many bytes of data are there in flight after this frame
@@ -2421,21 +2499,11 @@ finished_checking_retransmission_type:
      */
     ual=tcpd->fwd->tcp_analyze_seq_info->segments;
     if (tcp_track_bytes_in_flight && seglen!=0 && ual && tcpd->fwd->valid_bif) {
-        guint32 first_seq, last_seq, in_flight;
+        guint32 in_flight;
         guint32 delivered = 0;
 
-        first_seq = ual->seq - tcpd->fwd->base_seq;
-        last_seq = ual->nextseq - tcpd->fwd->base_seq;
-        while (ual) {
-            if ((ual->nextseq-tcpd->fwd->base_seq)>last_seq) {
-                last_seq = ual->nextseq-tcpd->fwd->base_seq;
-            }
-            if ((ual->seq-tcpd->fwd->base_seq)<first_seq) {
-                first_seq = ual->seq-tcpd->fwd->base_seq;
-            }
-            ual = ual->next;
-        }
-        in_flight = last_seq-first_seq;
+        /* The list is sorted, and we know the highest nextseq in it */
+        in_flight = tcpd->fwd->tcp_analyze_seq_info->segments_nextseq - ual->seq;
 
         /* subtract any SACK block */
         if(tcpd->rev->tcp_analyze_seq_info->num_sack_ranges > 0) {
@@ -3176,6 +3244,10 @@ static gboolean tcp_desegment = TRUE;
  * subdissector (depends on "tcp_desegment"). */
 static gboolean tcp_reassemble_out_of_order = FALSE;
 
+/* Refer to the segments' data in reassembled PDUs instead of copying it
+ * into one buffer (depends on "tcp_desegment"). */
+static gboolean tcp_reassemble_without_copying = FALSE;
+
 /* Returns true iff any gap exists in the segments associated with msp up to the
  * given sequence number (it ignores any gaps after the sequence number). */
 static gboolean
@@ -7239,6 +7311,8 @@ tcp_init(void)
     /* MPTCP init */
     mptcp_stream_count = 0;
     mptcp_tokens = wmem_tree_new(wmem_file_scope());
+
+    reassembly_table_set_composite(&tcp_reassembly_table, tcp_reassemble_without_copying);
 }
 
 void
@@ -8251,6 +8325,12 @@ proto_register_tcp(void)
         "Whether out-of-order segments should be buffered and reordered before passing it to a subdissector. "
         "To use this option you must also enable \"Allow subdissector to reassemble TCP streams\".",
         &tcp_reassemble_out_of_order);
+    prefs_register_bool_preference(tcp_module, "reassemble_without_copying",
+        "Reassemble PDUs without copying segment data",
+        "Whether reassembled PDUs should refer to the data of their segments instead of copying it into one buffer. "
+        "This saves memory with large PDUs, at some cost when a subdissector needs data spanning segments to be contiguous. "
+        "To use this option you must also enable \"Allow subdissector to reassemble TCP streams\".",
+        &tcp_reassemble_without_copying);
     prefs_register_bool_preference(tcp_module, "analyze_sequence_numbers",
         "Analyze TCP sequence numbers",
         "Make the TCP dissector analyze TCP sequence numbers to find and flag segment retransmissions, missing segments and RTT",
@@ -146,9 +146,13 @@ tcp_dissect_pdus(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 extern struct tcp_multisegment_pdu *
 pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, wmem_tree_t *multisegment_pdus);
 
+/* An unacked segment, or a range of them.  The list of these for a flow is
+ * kept sorted by sequence number, with the lowest first.
+ */
 typedef struct _tcp_unacked_t {
 	struct _tcp_unacked_t *next;
-	guint32 frame;
+	struct _tcp_unacked_t *prev;
+	guint32 frame;		/* 0 if this summarizes several segments */
 	guint32	seq;
 	guint32	nextseq;
 	nstime_t ts;
@@ -295,6 +299,8 @@ typedef enum {
  */
 typedef struct tcp_analyze_seq_flow_info_t {
 	tcp_unacked_t *segments;/* List of segments for which we haven't seen an ACK */
+	tcp_unacked_t *segments_last;	/* The one with the highest seq in that list */
+	guint32 segments_nextseq;	/* highest nextseq in that list */
 	guint16 segment_count;	/* How many unacked segments we're currently storing */
     guint32 lastack;	/* Last seen ack for the reverse flow */
 	nstime_t lastacktime;	/* Time of the last ack packet */
@@ -334,7 +340,7 @@ typedef struct tcp_process_info_t {
 typedef struct _tcp_flow_t {
 	guint8 static_flags; /* true if base seq set */
 	guint32 base_seq;	/* base seq number (used by relative sequence numbers)*/
-#define TCP_MAX_UNACKED_SEGMENTS 10000 /* The most unacked segments we'll store */
+#define TCP_MAX_UNACKED_SEGMENTS 10000 /* The most unacked segments we'll store before summarizing the oldest */
 	guint32 fin;		/* frame number of the final FIN */
 	guint32 window;		/* last seen window */
 	gint16	win_scale;	/* -1 is we don't know, -2 is window scaling is not used */
@@ -202,6 +202,12 @@ WS_DLL_PUBLIC
 void
 epan_dissect_fake_protocols(epan_dissect_t *edt, const gboolean fake_protocols);
 
+/** Indicate whether we should skip filling in the item labels of a visible
+    tree, for when only the values of its fields are going to be used */
+WS_DLL_PUBLIC
+void
+epan_dissect_skip_labels(epan_dissect_t *edt, const gboolean skip_labels);
+
 /** run a single packet dissection */
 WS_DLL_PUBLIC
 void
@@ -19,6 +19,13 @@
 #include <epan/column-utils.h>
 #include <epan/timestamp.h>
 
+/*
+ * Time shift offsets of the frames that have been time shifted, keyed
+ * by the frame_data pointer; only frames with has_shift_offset set
+ * have an entry.
+ */
+static GHashTable *shift_offsets = NULL;
+
 #define COMPARE_FRAME_NUM()     ((fdata1->num < fdata2->num) ? -1 : \
                                  (fdata1->num > fdata2->num) ? 1 : \
                                  0)
@@ -211,8 +218,7 @@ frame_data_init(frame_data *fdata, guint32 num, const wtap_rec *rec,
   fdata->has_user_comment = 0;
   fdata->need_colorize = 0;
   fdata->color_filter = NULL;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
+  fdata->has_shift_offset = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
 }
@@ -267,6 +273,49 @@ frame_data_set_after_dissect(frame_data *fdata,
   }
 }
 
+void
+frame_data_get_shift_offset(const frame_data *fdata, nstime_t *shift_offset)
+{
+  nstime_t *offset = NULL;
+
+  if (fdata->has_shift_offset && shift_offsets != NULL)
+    offset = (nstime_t *)g_hash_table_lookup(shift_offsets, fdata);
+
+  if (offset != NULL)
+    *shift_offset = *offset;
+  else
+    nstime_set_zero(shift_offset);
+}
+
+static void
+frame_data_remove_shift_offset(frame_data *fdata)
+{
+  if (fdata->has_shift_offset) {
+    if (shift_offsets != NULL)
+      g_hash_table_remove(shift_offsets, fdata);
+    fdata->has_shift_offset = 0;
+  }
+}
+
+void
+frame_data_set_shift_offset(frame_data *fdata, const nstime_t *shift_offset)
+{
+  nstime_t *offset;
+
+  if (shift_offset->secs == 0 && shift_offset->nsecs == 0) {
+    frame_data_remove_shift_offset(fdata);
+    return;
+  }
+
+  if (shift_offsets == NULL)
+    shift_offsets = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                          NULL, g_free);
+  offset = g_new(nstime_t, 1);
+  *offset = *shift_offset;
+  g_hash_table_insert(shift_offsets, fdata, offset);
+  fdata->has_shift_offset = 1;
+}
+
 void
 frame_data_reset(frame_data *fdata)
 {
@@ -288,6 +337,15 @@ frame_data_destroy(frame_data *fdata)
   }
 }
 
+void
+frame_data_free_shift_offsets(void)
+{
+  if (shift_offsets != NULL) {
+    g_hash_table_destroy(shift_offsets);
+    shift_offsets = NULL;
+  }
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -88,9 +88,11 @@ typedef struct _frame_data {
   unsigned int has_user_comment : 1; /** 1 = user set (also deleted) comment for this packet */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
-  nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
+  unsigned int has_shift_offset : 1; /**< 1 = abs_ts has been time shifted; see frame_data_get_shift_offset() */
+  /* Put this here, so it fills what would otherwise be padding before
+     the nstime_t. */
   guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
+  nstime_t     abs_ts;       /**< Absolute timestamp */
   guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
 } frame_data;
 DIAG_ON_PEDANTIC
@@ -106,6 +108,28 @@ WS_DLL_PUBLIC void frame_data_init(frame_data *fdata, guint32 num,
                 const wtap_rec *rec, gint64 offset,
                 guint32 cum_bytes);
 
+/**
+ * Get how much the absolute time stamp of a frame has been shifted by
+ * the user; that's zero unless the frame has been time shifted.
+ *
+ * Shifting is rare, so the offset isn't stored in the frame_data itself.
+ */
+WS_DLL_PUBLIC void frame_data_get_shift_offset(const frame_data *fdata,
+                nstime_t *shift_offset);
+
+/**
+ * Set how much the absolute time stamp of a frame has been shifted by
+ * the user.  This doesn't change abs_ts; the caller does that.
+ */
+WS_DLL_PUBLIC void frame_data_set_shift_offset(frame_data *fdata,
+                const nstime_t *shift_offset);
+
+/**
+ * Forget the time shift offsets of all frames; called when the frames
+ * of a capture file are freed.
+ */
+WS_DLL_LOCAL void frame_data_free_shift_offsets(void);
+
 extern void frame_delta_abs_time(const struct epan_session *epan, const frame_data *fdata,
                 guint32 prev_num, nstime_t *delta);
 /**
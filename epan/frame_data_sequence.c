@@ -307,6 +307,9 @@ free_frame_data_sequence(frame_data_sequence *fds)
     free_frame_data_array(fds->ptree_root, fds->count, levels, TRUE);
   }
 
+  /* the time shift offsets are keyed by the frames we just freed */
+  frame_data_free_shift_offsets();
+
   /* free the header struct */
   g_free(fds);
 }
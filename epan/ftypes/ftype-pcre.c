@@ -18,6 +18,22 @@
 #include <glib.h>
 #include <string.h>
 
+struct _fvalue_regex_t {
+    GRegex     *code;
+    /*
+     * If the pattern has no special characters, it's a plain string that
+     * is matched caselessly anywhere in the subject; this is the
+     * lower-cased pattern, so we can search for it without going through
+     * the regex engine, which allocates and frees a match context on
+     * every call.
+     */
+    guint8     *literal;
+    gsize       literal_len;
+};
+
+/* Characters that have a special meaning outside of a character class */
+#define REGEX_SPECIAL_CHARS "\\^$.[|()?*+{"
+
 static void
 gregex_fvalue_new(fvalue_t *fv)
 {
@@ -28,7 +44,11 @@ static void
 gregex_fvalue_free(fvalue_t *fv)
 {
     if (fv->value.re) {
-        g_regex_unref(fv->value.re);
+        if (fv->value.re->code) {
+            g_regex_unref(fv->value.re->code);
+        }
+        g_free(fv->value.re->literal);
+        g_free(fv->value.re);
         fv->value.re = NULL;
     }
 }
@@ -40,7 +60,9 @@ static gboolean
 val_from_string(fvalue_t *fv, const char *pattern, gchar **err_msg)
 {
     GError *regex_error = NULL;
+    GRegex *code;
     GRegexCompileFlags cflags = (GRegexCompileFlags)(G_REGEX_CASELESS | G_REGEX_OPTIMIZE);
+    gsize i;
 
     /*
      * As FT_BYTES and FT_PROTOCOL contain arbitrary binary data and FT_STRING
@@ -56,7 +78,7 @@ val_from_string(fvalue_t *fv, const char *pattern, gchar **err_msg)
     /* Free up the old value, if we have one */
     gregex_fvalue_free(fv);
 
-    fv->value.re = g_regex_new(
+    code = g_regex_new(
             pattern,            /* pattern */
             cflags,             /* Compile options */
             (GRegexMatchFlags)0,                  /* Match options */
@@ -68,14 +90,71 @@ val_from_string(fvalue_t *fv, const char *pattern, gchar **err_msg)
             *err_msg = g_strdup(regex_error->message);
         }
         g_error_free(regex_error);
-        if (fv->value.re) {
-            g_regex_unref(fv->value.re);
+        if (code) {
+            g_regex_unref(code);
         }
         return FALSE;
     }
+
+    fv->value.re = g_new0(fvalue_regex_t, 1);
+    fv->value.re->code = code;
+
+    /*
+     * In raw mode, caseless matching only folds ASCII letters, so for a
+     * plain string an ASCII caseless search gives the same answer.
+     */
+    if (strpbrk(pattern, REGEX_SPECIAL_CHARS) == NULL) {
+        fv->value.re->literal_len = strlen(pattern);
+        fv->value.re->literal = (guint8 *)g_malloc(fv->value.re->literal_len + 1);
+        for (i = 0; i <= fv->value.re->literal_len; i++) {
+            fv->value.re->literal[i] = g_ascii_tolower(pattern[i]);
+        }
+    }
     return TRUE;
 }
 
+gboolean
+fvalue_regex_matches(const fvalue_regex_t *re, const char *subj, gsize subj_len)
+{
+    const guint8 *data = (const guint8 *)subj;
+    const guint8 *needle = re->literal;
+    gsize needle_len = re->literal_len;
+    gsize i, j;
+
+    if (needle == NULL) {
+        return g_regex_match_full(
+                re->code,           /* Compiled PCRE */
+                subj,               /* The data to check for the pattern... */
+                (gssize)subj_len,   /* ... and its length */
+                0,                  /* Start offset within data */
+                (GRegexMatchFlags)0,    /* GRegexMatchFlags */
+                NULL,               /* We are not interested in the match information */
+                NULL                /* We don't want error information */
+                );
+    }
+
+    if (needle_len == 0) {
+        return TRUE;
+    }
+    if (subj_len < needle_len) {
+        return FALSE;
+    }
+    for (i = 0; i <= subj_len - needle_len; i++) {
+        if (g_ascii_tolower(data[i]) != needle[0]) {
+            continue;
+        }
+        for (j = 1; j < needle_len; j++) {
+            if (g_ascii_tolower(data[i + j]) != needle[j]) {
+                break;
+            }
+        }
+        if (j == needle_len) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 /* Generate a FT_PCRE from an unparsed string pattern.
  * On failure, if err_msg is non-null, set *err_msg to point to a
  * g_malloc()ed error message. */
@@ -91,14 +170,14 @@ static int
 gregex_repr_len(fvalue_t *fv, ftrepr_t rtype, int field_display _U_)
 {
     g_assert(rtype == FTREPR_DFILTER);
-    return (int)strlen(g_regex_get_pattern(fv->value.re));
+    return (int)strlen(g_regex_get_pattern(fv->value.re->code));
 }
 
 static void
 gregex_to_repr(fvalue_t *fv, ftrepr_t rtype, int field_display _U_, char *buf, unsigned int size)
 {
     g_assert(rtype == FTREPR_DFILTER);
-    g_strlcpy(buf, g_regex_get_pattern(fv->value.re), size);
+    g_strlcpy(buf, g_regex_get_pattern(fv->value.re->code), size);
 }
 
 /* BEHOLD - value contains the string representation of the regular expression,
@@ -115,7 +194,7 @@ gregex_fvalue_set(fvalue_t *fv, const char *value)
 static gpointer
 gregex_fvalue_get(fvalue_t *fv)
 {
-    return fv->value.re;
+    return fv->value.re ? fv->value.re->code : NULL;
 }
 
 void
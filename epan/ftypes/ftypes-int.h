@@ -34,6 +34,10 @@ void ftype_register_time(void);
 void ftype_register_tvbuff(void);
 void ftype_register_pcre(void);
 
+/* Returns TRUE if the FT_PCRE pattern matches anywhere in the subject */
+gboolean
+fvalue_regex_matches(const fvalue_regex_t *re, const char *subj, gsize subj_len);
+
 typedef void (*FvalueNewFunc)(fvalue_t*);
 typedef void (*FvalueFreeFunc)(fvalue_t*);
 
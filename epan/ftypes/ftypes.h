@@ -222,6 +222,9 @@ typedef struct _protocol_value_t
 	gchar		*proto_string;
 } protocol_value_t;
 
+/* Compiled "matches" pattern, private to ftype-pcre.c */
+typedef struct _fvalue_regex_t fvalue_regex_t;
+
 typedef struct _fvalue_t {
 	ftype_t	*ftype;
 	union {
@@ -240,7 +243,7 @@ typedef struct _fvalue_t {
 		e_guid_t		guid;
 		nstime_t		time;
 		protocol_value_t 	protocol;
-		GRegex			*re;
+		fvalue_regex_t		*re;
 		guint16			sfloat_ieee_11073;
 		guint32			float_ieee_11073;
 	} value;
@@ -14,6 +14,7 @@
 #include "config.h"
 
 #include <glib.h>
+#include <string.h>
 
 #include <epan/tvbuff.h>
 #include <epan/in_cksum.h>
@@ -76,17 +77,32 @@ in_cksum(const vec_t *vec, int veclen)
 			byte_swapped = 1;
 		}
 		/*
-		 * Unroll the loop to make overhead from
-		 * branches &c small.
+		 * Do the bulk of the data 32 bits at a time, into a 64-bit
+		 * accumulator, unrolling the loop to make overhead from
+		 * branches &c small.  Folded down to 16 bits, the one's
+		 * complement sum of 32-bit words is the same as the sum
+		 * of the 16-bit words (RFC 1071, section 2 (C)), and the
+		 * accumulator can't overflow.
 		 */
-		while ((mlen -= 32) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
-			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
-			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
-			w += 16;
+		if (mlen >= 32) {
+			guint64 wsum = 0;
+			guint32 l[8];
+
+			while ((mlen -= 32) >= 0) {
+				/* w is only 16-bit aligned */
+				memcpy(l, w, sizeof l);
+				wsum += l[0]; wsum += l[1]; wsum += l[2]; wsum += l[3];
+				wsum += l[4]; wsum += l[5]; wsum += l[6]; wsum += l[7];
+				w += 16;
+			}
+			mlen += 32;
+			wsum = (wsum & 0xffffffff) + (wsum >> 32);
+			wsum = (wsum & 0xffff) + (wsum >> 16);
+			wsum = (wsum & 0xffff) + (wsum >> 16);
+			wsum = (wsum & 0xffff) + (wsum >> 16);
+			REDUCE;
+			sum += (int)wsum;
 		}
-		mlen += 32;
 		while ((mlen -= 8) >= 0) {
 			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
 			w += 4;
@@ -81,6 +81,8 @@ struct _output_fields {
     GPtrArray   **field_values;
     gchar         quote;
     gboolean      includes_col_fields;
+    gboolean      labels_checked;
+    gboolean      needs_labels;
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -2158,6 +2160,63 @@ output_fields_valid(output_fields_t *fields)
     return invalid_fields;
 }
 
+/*
+ * Check whether any of the user selected fields is printed using the
+ * item's label rather than the field's value.
+ */
+static gboolean
+output_fields_check_labels(output_fields_t *fields)
+{
+    header_field_info *hfinfo;
+    const gchar *field;
+    gsize i;
+
+    if (fields->fields == NULL) {
+        return FALSE;
+    }
+
+    for (i = 0; i < fields->fields->len; ++i) {
+        field = (const gchar *)g_ptr_array_index(fields->fields, i);
+
+        if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+            continue;
+
+        hfinfo = proto_registrar_get_byname(field);
+        if (!hfinfo) {
+            /* We don't know what it is, so play it safe. */
+            return TRUE;
+        }
+
+        /* Check every field registered with this name. */
+        while (hfinfo->same_name_prev_id != -1) {
+            hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+        }
+        for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            /*
+             * Text items and protocols (other than "Data", which is
+             * printed as hex) are printed using their label.
+             */
+            if (hfinfo->id == hf_text_only ||
+                (hfinfo->type == FT_PROTOCOL && hfinfo->id != proto_data)) {
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+gboolean
+output_fields_need_labels(output_fields_t *fields)
+{
+    g_assert(fields);
+
+    if (!fields->labels_checked) {
+        fields->needs_labels = output_fields_check_labels(fields);
+        fields->labels_checked = TRUE;
+    }
+    return fields->needs_labels;
+}
+
 gboolean output_fields_set_option(output_fields_t *info, gchar *option)
 {
     const gchar *option_name;
@@ -2733,6 +2792,8 @@ output_fields_t* output_fields_new(void)
     fields->field_values        = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->labels_checked      = FALSE;
+    fields->needs_labels        = FALSE;
     return fields;
 }
 
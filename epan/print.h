@@ -71,6 +71,13 @@ WS_DLL_PUBLIC gboolean output_fields_set_option(output_fields_t* info, gchar* op
 WS_DLL_PUBLIC void output_fields_list_options(FILE *fh);
 WS_DLL_PUBLIC gboolean output_fields_has_cols(output_fields_t* info);
 
+/*
+ * Returns TRUE if some of the user selected fields are printed using
+ * their item label, so the labels of the protocol tree items must be
+ * filled in; otherwise, only the field values are used.
+ */
+WS_DLL_PUBLIC gboolean output_fields_need_labels(output_fields_t* info);
+
 /*
  * Higher-level packet-printing code.
  */
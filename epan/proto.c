@@ -140,11 +140,15 @@ struct ptvcursor {
 	TRY_TO_FAKE_THIS_ITEM_OR_FREE(tree, hfindex, hfinfo, ((void)0))
 
 
+/* Are the labels of the items in this tree going to be used? */
+#define TREE_HAS_LABELS(pi) \
+	(PTREE_DATA(pi)->visible && !PTREE_DATA(pi)->skip_labels)
+
 /** See inlined comments.
  @param pi the created protocol item we're about to return */
 #define TRY_TO_FAKE_THIS_REPR(pi)	\
 	g_assert(pi);			\
-	if (!(PTREE_DATA(pi)->visible)) { \
+	if (!TREE_HAS_LABELS(pi)) { \
 		/* If the tree (GUI) isn't visible it's pointless for us to generate the protocol \
 		 * items string representation */ \
 		return pi; \
@@ -153,14 +157,14 @@ struct ptvcursor {
 #define TRY_TO_FAKE_THIS_REPR_VOID(pi)	\
 	if (!pi)			\
 		return;			\
-	if (!(PTREE_DATA(pi)->visible)) { \
+	if (!TREE_HAS_LABELS(pi)) { \
 		/* If the tree (GUI) isn't visible it's pointless for us to generate the protocol \
 		 * items string representation */ \
 		return; \
 	}
 /* Similar to above, but allows a NULL tree */
 #define TRY_TO_FAKE_THIS_REPR_NESTED(pi)	\
-	if ((pi == NULL) || (!(PTREE_DATA(pi)->visible))) { \
+	if ((pi == NULL) || (!TREE_HAS_LABELS(pi))) { \
 		/* If the tree (GUI) isn't visible it's pointless for us to generate the protocol \
 		 * items string representation */ \
 		return pi; \
@@ -816,6 +820,17 @@ proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols)
 	PTREE_DATA(tree)->fake_protocols = fake_protocols;
 }
 
+/* Should the items of a visible tree get a label?  If they shouldn't, the
+ * tree is still built as a visible one, with no item faked, so that all of
+ * the fields end up in the same place and order; only formatting their
+ * text representation is skipped.
+ */
+void
+proto_tree_set_skip_labels(proto_tree *tree, gboolean skip_labels)
+{
+	PTREE_DATA(tree)->skip_labels = skip_labels;
+}
+
 /* Assume dissector set only its protocol fields.
    This function is called by dissectors and allows the speeding up of filtering
    in wireshark; if this function returns FALSE it is safe to reset tree to NULL
@@ -6249,7 +6264,7 @@ proto_tree_set_representation_value(proto_item *pi, const char *format, va_list
 
 	/* If the tree (GUI) or item isn't visible it's pointless for us to generate the protocol
 	 * items string representation */
-	if (PTREE_DATA(pi)->visible && !proto_item_is_hidden(pi)) {
+	if (TREE_HAS_LABELS(pi) && !proto_item_is_hidden(pi)) {
 		int               ret = 0;
 		field_info        *fi = PITEM_FINFO(pi);
 		header_field_info *hf;
@@ -7131,6 +7146,9 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Make sure that we fake protocols (if possible) */
 	pnode->tree_data->fake_protocols = TRUE;
 
+	/* Fill in the labels if the tree is visible */
+	pnode->tree_data->skip_labels = FALSE;
+
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
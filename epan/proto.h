@@ -859,6 +859,7 @@ typedef struct {
     GHashTable          *interesting_hfids;
     gboolean             visible;
     gboolean             fake_protocols;
+    gboolean             skip_labels;
     guint                count;
     struct _packet_info *pinfo;
 } tree_data_t;
@@ -1176,6 +1177,14 @@ proto_tree_set_visible(proto_tree *tree, gboolean visible);
 extern void
 proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols);
 
+/** Indicate whether we should skip filling in the labels of the items of a
+ visible tree (default = FALSE). The tree is built exactly as a visible one,
+ but the items have no text representation.
+ @param tree the tree to be set
+ @param skip_labels TRUE if we should skip the labels */
+extern void
+proto_tree_set_skip_labels(proto_tree *tree, gboolean skip_labels);
+
 /** Mark a field/protocol ID as "interesting".
  @param tree the tree to be set (currently ignored)
  @param hfid the interesting field id
@@ -422,6 +422,15 @@ reassembly_table_register(reassembly_table *table,
 	reassembly_table_list = g_list_prepend(reassembly_table_list, reg_table);
 }
 
+/*
+ * Set whether new reassemblies in a table use composite tvbuffs.
+ */
+void
+reassembly_table_set_composite(reassembly_table *table, const gboolean composite)
+{
+	table->composite_tvbs = composite;
+}
+
 /*
  * Initialize a reassembly table, with specified functions.
  */
@@ -573,6 +582,8 @@ insert_fd_head(reassembly_table *table, fragment_head *fd_head,
 	 */
 	key = table->persistent_key_func(pinfo, id, data);
 	g_hash_table_insert(table->fragment_table, key, fd_head);
+	if (table->composite_tvbs)
+		fd_head->flags |= FD_COMPOSITE_TVB;
 	return key;
 }
 
@@ -604,6 +615,15 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 	}
 
 	fd_tvb_data=fd_head->tvb_data;
+	if (fd_tvb_data && (fd_head->flags & FD_COMPOSITE_TVB)) {
+		/*
+		 * The reassembled data refers to the fragments' data,
+		 * which is about to go away, so hand back a copy.
+		 */
+		fd_head->tvb_data = tvb_clone(fd_tvb_data);
+		tvb_free(fd_tvb_data);
+		fd_tvb_data = fd_head->tvb_data;
+	}
 	/* loop over all partial fragments and free any tvbuffs */
 	for(fd=fd_head->next;fd;){
 		fragment_item *tmp_fd;
@@ -968,6 +988,47 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 	fd_i->next = fd;
 }
 
+/*
+ * For a reassembly table that uses composite tvbuffs for the reassembled
+ * data, the fragments keep their data once the reassembly is complete,
+ * as the composite refers to it.
+ *
+ * A fragment's data might be a subset of the data from an earlier
+ * reassembly of the same PDU, which is freed when the PDU is reassembled
+ * again; make it a copy of its own if so.
+ */
+static void
+fragment_own_tvb_data(fragment_item *fd)
+{
+	if (fd->tvb_data && (fd->flags & FD_SUBSET_TVB)) {
+		fd->tvb_data = tvb_clone(fd->tvb_data);
+		fd->flags &= ~FD_SUBSET_TVB;
+	}
+}
+
+/*
+ * A fragment overlapping the data before it, whose overlapping bytes
+ * still have to be compared with that data.
+ */
+typedef struct {
+	fragment_item *fd;
+	guint32 cmp_len;
+} fragment_overlap_t;
+
+/*
+ * Add len bytes of a fragment's data, starting at offset, to a composite.
+ */
+static void
+fragment_composite_append(tvbuff_t *composite, fragment_item *fd,
+			  const guint32 offset, const guint32 len)
+{
+	if (offset == 0 && len == tvb_captured_length(fd->tvb_data))
+		tvb_composite_append(composite, fd->tvb_data);
+	else
+		tvb_composite_append(composite,
+		    tvb_new_subset_length_caplen(fd->tvb_data, offset, len, len));
+}
+
 /*
  * This function adds a new fragment to the fragment hash table.
  * If this is the first fragment seen for this datagram, a new entry
@@ -999,6 +1060,9 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	guint32 max, dfpos, fraglen, overlap;
 	tvbuff_t *old_tvb_data;
 	guint8 *data;
+	gboolean composite;
+	guint composite_members = 0;
+	GArray *overlaps = NULL;
 
 	/* create new fd describing this fragment */
 	fd = g_slice_new(fragment_item);
@@ -1190,13 +1254,25 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	 */
 	/* store old data just in case */
 	old_tvb_data=fd_head->tvb_data;
-	data = (guint8 *) g_malloc(fd_head->datalen);
-	fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
-	tvb_set_free_cb(fd_head->tvb_data, g_free);
+	composite = (fd_head->flags & FD_COMPOSITE_TVB) && fd_head->datalen;
+	if (composite) {
+		/*
+		 * Rather than copying the data of the fragments into
+		 * one buffer, make a composite tvbuff that refers to it.
+		 */
+		data = NULL;
+		fd_head->tvb_data = tvb_new_composite_detached();
+	} else {
+		data = (guint8 *) g_malloc(fd_head->datalen);
+		fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
+		tvb_set_free_cb(fd_head->tvb_data, g_free);
+	}
 
 	/* add all data fragments */
 	for (dfpos=0,fd_i=fd_head;fd_i;fd_i=fd_i->next) {
 		if (fd_i->len) {
+			if (composite)
+				fragment_own_tvb_data(fd_i);
 			/*
 			 * The loop above that calculates max also
 			 * ensures that the only gaps that exist here
@@ -1272,7 +1348,19 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 
 					fd_i->flags    |= FD_OVERLAP;
 					fd_head->flags |= FD_OVERLAP;
-					if ( memcmp(data + fd_i->offset,
+					if (composite) {
+						/*
+						 * The bytes this overlaps came
+						 * from earlier fragments, and
+						 * can be compared once the
+						 * composite is complete.
+						 */
+						fragment_overlap_t ov = { fd_i, cmp_len };
+
+						if (!overlaps)
+							overlaps = g_array_new(FALSE, FALSE, sizeof(fragment_overlap_t));
+						g_array_append_val(overlaps, ov);
+					} else if ( memcmp(data + fd_i->offset,
 							tvb_get_ptr(fd_i->tvb_data, 0, cmp_len),
 							cmp_len)
 							 ) {
@@ -1300,19 +1388,53 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 				 * out rather than mixed with the new ones?
 				 */
 				if (fd_i->offset + fraglen > dfpos) {
-					memcpy(data+dfpos,
-						tvb_get_ptr(fd_i->tvb_data, overlap, fraglen-overlap),
-						fraglen-overlap);
+					if (composite) {
+						fragment_composite_append(fd_head->tvb_data,
+						    fd_i, overlap, fraglen-overlap);
+						composite_members++;
+					} else {
+						memcpy(data+dfpos,
+							tvb_get_ptr(fd_i->tvb_data, overlap, fraglen-overlap),
+							fraglen-overlap);
+					}
 					dfpos = fd_i->offset + fraglen;
 				}
 			}
 
-			if (fd_i->flags & FD_SUBSET_TVB)
-				fd_i->flags &= ~FD_SUBSET_TVB;
-			else if (fd_i->tvb_data)
-				tvb_free(fd_i->tvb_data);
+			/* A composite refers to the data, so keep it */
+			if (!composite) {
+				if (fd_i->flags & FD_SUBSET_TVB)
+					fd_i->flags &= ~FD_SUBSET_TVB;
+				else if (fd_i->tvb_data)
+					tvb_free(fd_i->tvb_data);
 
-			fd_i->tvb_data=NULL;
+				fd_i->tvb_data=NULL;
+			}
+		}
+	}
+
+	if (composite) {
+		if (composite_members) {
+			tvb_composite_finalize(fd_head->tvb_data);
+		} else {
+			/* Nothing usable in any of the fragments */
+			tvb_free(fd_head->tvb_data);
+			data = (guint8 *) g_malloc0(fd_head->datalen);
+			fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
+			tvb_set_free_cb(fd_head->tvb_data, g_free);
+		}
+		if (overlaps) {
+			for (guint i = 0; i < overlaps->len; i++) {
+				fragment_overlap_t *ov = &g_array_index(overlaps, fragment_overlap_t, i);
+
+				if (tvb_memeql(fd_head->tvb_data, ov->fd->offset,
+						tvb_get_ptr(ov->fd->tvb_data, 0, ov->cmp_len),
+						ov->cmp_len)) {
+					ov->fd->flags  |= FD_OVERLAPCONFLICT;
+					fd_head->flags |= FD_OVERLAPCONFLICT;
+				}
+			}
+			g_array_free(overlaps, TRUE);
 		}
 	}
 
@@ -1628,6 +1750,7 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 	guint32  dfpos = 0, size = 0;
 	tvbuff_t *old_tvb_data = NULL;
 	guint8 *data;
+	gboolean composite;
 
 	for(fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
 		if(!last_fd || last_fd->offset!=fd_i->offset){
@@ -1638,9 +1761,18 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 
 	/* store old data in case the fd_i->data pointers refer to it */
 	old_tvb_data=fd_head->tvb_data;
-	data = (guint8 *) g_malloc(size);
-	fd_head->tvb_data = tvb_new_real_data(data, size, size);
-	tvb_set_free_cb(fd_head->tvb_data, g_free);
+	composite = (fd_head->flags & FD_COMPOSITE_TVB) && size;
+	if (composite) {
+		/* Refer to the data of the fragments rather than copying it */
+		data = NULL;
+		fd_head->tvb_data = tvb_new_composite_detached();
+		for (fd_i=fd_head->next; fd_i; fd_i=fd_i->next)
+			fragment_own_tvb_data(fd_i);
+	} else {
+		data = (guint8 *) g_malloc(size);
+		fd_head->tvb_data = tvb_new_real_data(data, size, size);
+		tvb_set_free_cb(fd_head->tvb_data, g_free);
+	}
 	fd_head->len = size;		/* record size for caller	*/
 
 	/* add all data fragments */
@@ -1649,7 +1781,10 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 		if (fd_i->len) {
 			if(!last_fd || last_fd->offset != fd_i->offset) {
 				/* First fragment or in-sequence fragment */
-				memcpy(data+dfpos, tvb_get_ptr(fd_i->tvb_data, 0, fd_i->len), fd_i->len);
+				if (composite)
+					fragment_composite_append(fd_head->tvb_data, fd_i, 0, fd_i->len);
+				else
+					memcpy(data+dfpos, tvb_get_ptr(fd_i->tvb_data, 0, fd_i->len), fd_i->len);
 				dfpos += fd_i->len;
 			} else {
 				/* duplicate/retransmission/overlap */
@@ -1665,13 +1800,18 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 		last_fd=fd_i;
 	}
 
-	/* we have defragmented the pdu, now free all fragments*/
-	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
-		if (fd_i->flags & FD_SUBSET_TVB)
-			fd_i->flags &= ~FD_SUBSET_TVB;
-		else if (fd_i->tvb_data)
-			tvb_free(fd_i->tvb_data);
-		fd_i->tvb_data=NULL;
+	if (composite) {
+		/* The composite refers to the fragments' data, so keep it */
+		tvb_composite_finalize(fd_head->tvb_data);
+	} else {
+		/* we have defragmented the pdu, now free all fragments*/
+		for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
+			if (fd_i->flags & FD_SUBSET_TVB)
+				fd_i->flags &= ~FD_SUBSET_TVB;
+			else if (fd_i->tvb_data)
+				tvb_free(fd_i->tvb_data);
+			fd_i->tvb_data=NULL;
+		}
 	}
 	if (old_tvb_data)
 		tvb_free(old_tvb_data);
@@ -49,6 +49,11 @@
  */
 #define FD_DATALEN_SET		0x0400
 
+/* only in fd_head: the reassembled data is a composite tvbuff referring
+ * to the data of the fragments, which is kept until the head is freed
+ * (see reassembly_table_set_composite()) */
+#define FD_COMPOSITE_TVB	0x0800
+
 typedef struct _fragment_item {
 	struct _fragment_item *next;
 	guint32 frame;			/* XXX - does this apply to reassembly heads? */
@@ -130,6 +135,7 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+	gboolean composite_tvbs;			/* reassemble into composite tvbuffs */
 } reassembly_table;
 
 /*
@@ -175,6 +181,16 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * Set whether reassemblies started from now on make the reassembled data
+ * a composite tvbuff that refers to the data of the fragments, rather
+ * than copying all of it into one buffer.  That saves a copy, and the
+ * memory for it, for large PDUs; the data is only made contiguous if a
+ * dissector asks for a pointer to a range that spans fragments.
+ */
+WS_DLL_PUBLIC void
+reassembly_table_set_composite(reassembly_table *table, const gboolean composite);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
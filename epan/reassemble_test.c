@@ -2381,6 +2381,72 @@ test_fragment_add_duplicate_conflict(void)
 #endif
 }
 
+/* Test case for a table that reassembles into composite tvbuffs.
+ * Adds three fragments, the second overlapping the first with the same data,
+ * and checks that the reassembled data refers to the fragments' data.
+ */
+/*   visit  id  frame  frag_off  len  more  tvb_offset
+       0    12     1       0     50   T      10
+       0    12     2      40     60   T      50
+       0    12     3     100     60   F      5
+*/
+static void
+test_fragment_add_composite(void)
+{
+    fragment_head *fd_head;
+    fragment_item *fd;
+
+    printf("Starting test test_fragment_add_composite\n");
+
+    reassembly_table_set_composite(&test_reassembly_table, TRUE);
+
+    pinfo.num = 1;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                         0, 50, TRUE);
+
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    /* Add the 2nd segment, whose first 10 bytes repeat the 1st one's last */
+    pinfo.num = 2;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 50, &pinfo, 12, NULL,
+                         40, 60, TRUE);
+
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    /* finally, add the last fragment */
+    pinfo.num = 3;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 5, &pinfo, 12, NULL,
+                         100, 60, FALSE);
+
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_NE_POINTER(NULL,fd_head);
+
+    /* check the contents of the structure */
+    ASSERT_EQ(3,fd_head->frame);  /* max frame we have */
+    ASSERT_EQ(160,fd_head->datalen);
+    ASSERT_EQ(3,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET|FD_OVERLAP|FD_COMPOSITE_TVB,fd_head->flags);
+    ASSERT_NE_POINTER(NULL,fd_head->tvb_data);
+    ASSERT_EQ(160,tvb_captured_length(fd_head->tvb_data));
+
+    /* the fragments keep the data the reassembled data refers to */
+    for (fd = fd_head->next; fd; fd = fd->next) {
+        ASSERT_NE_POINTER(NULL,fd->tvb_data);
+    }
+
+    /* search across the fragments without flattening the data */
+    ASSERT_EQ(102,tvb_find_guint8(fd_head->tvb_data,60,-1,7));
+
+    /* test the actual reassembly */
+    ASSERT(!tvb_memeql(fd_head->tvb_data,0,data+10,50));
+    ASSERT(!tvb_memeql(fd_head->tvb_data,50,data+60,50));
+    ASSERT(!tvb_memeql(fd_head->tvb_data,100,data+5,60));
+
+    reassembly_table_set_composite(&test_reassembly_table, FALSE);
+}
+
 /**********************************************************************************
  *
  * fragment_add_check
@@ -3300,6 +3366,7 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_duplicate_middle,
         test_fragment_add_duplicate_last,
         test_fragment_add_duplicate_conflict,
+        test_fragment_add_composite,
         test_simple_fragment_add_check,              /* frag table only   */
 #if 0
         test_fragment_add_check_partial_reassembly,
@@ -1378,9 +1378,13 @@ epan_memmem(const guint8 *haystack, guint haystack_len,
     }
 
     for (begin = haystack ; begin <= last_possible; ++begin) {
-        if (begin[0] == needle[0] &&
-                !memcmp(&begin[1], needle + 1,
-                    needle_len - 1)) {
+        /* memchr() is usually vectorized, so use it to skip to the
+         * next possible match. */
+        begin = (const guint8 *)memchr(begin, needle[0], last_possible - begin + 1);
+        if (begin == NULL) {
+            break;
+        }
+        if (!memcmp(&begin[1], needle + 1, needle_len - 1)) {
             return begin;
         }
     }
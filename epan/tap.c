@@ -76,6 +76,28 @@ typedef struct _tap_packet_t {
 static tap_packet_t tap_packet_array[TAP_PACKET_QUEUE_LEN];
 static guint tap_packet_index;
 
+/*
+ * Tap listener filters.
+ *
+ * Many listeners are often registered with the same filter string (for
+ * example a dialog registering one listener per protocol layer, or several
+ * -z statistics sharing a display filter), and a single packet may be
+ * queued for the same tap more than once. Listeners therefore share one
+ * compiled filter per distinct filter string, and each filter is run at
+ * most once per packet; its result is remembered until the next packet is
+ * pushed.
+ */
+typedef struct _tap_filter_t {
+	struct _tap_filter_t *next;
+	gchar *fstring;
+	dfilter_t *code;
+	guint refcount;
+	gboolean evaluated;	/* "passed" is valid for the current packet */
+	gboolean passed;
+} tap_filter_t;
+
+static tap_filter_t *tap_filter_list=NULL;
+
 typedef struct _tap_listener_t {
 	struct _tap_listener_t *next;
 	int tap_id;
@@ -83,7 +105,7 @@ typedef struct _tap_listener_t {
 	gboolean failed;
 	guint flags;
 	gchar *fstring;
-	dfilter_t *code;
+	tap_filter_t *filter;
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -260,18 +282,18 @@ tap_queue_packet(int tap_id, packet_info *pinfo, const void *tap_specific_data)
 
 void tap_build_interesting (epan_dissect_t *edt)
 {
-	tap_listener_t *tl;
+	tap_filter_t *tf;
 
 	/* nothing to do, just return */
 	if(!tap_listener_queue){
 		return;
 	}
 
-	/* loop over all tap listeners and build the list of all
+	/* loop over all tap listener filters and build the list of all
 	   interesting hf_fields */
-	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code){
-			epan_dissect_prime_with_dfilter(edt, tl->code);
+	for(tf=tap_filter_list;tf;tf=tf->next){
+		if(tf->code){
+			epan_dissect_prime_with_dfilter(edt, tf->code);
 		}
 	}
 }
@@ -303,6 +325,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 {
 	tap_packet_t *tp;
 	tap_listener_t *tl;
+	tap_filter_t *tf;
 	guint i;
 
 	/* nothing to do, just return */
@@ -317,6 +340,11 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	/* forget the filter results for the previous packet */
+	for(tf=tap_filter_list;tf;tf=tf->next){
+		tf->evaluated=FALSE;
+	}
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
@@ -346,8 +374,13 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					/* If we have a filter, see if the
 					 * packet passes.
 					 */
-					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+					tf=tl->filter;
+					if(tf){
+						if(!tf->evaluated){
+							tf->passed=!tf->code || dfilter_apply_edt(tf->code, edt);
+							tf->evaluated=TRUE;
+						}
+						if(!tf->passed){
 							/* The packet didn't
 							 * pass the filter. */
 							continue;
@@ -503,6 +536,65 @@ find_tap_id(const char *name)
 	return 0;
 }
 
+/* Finds the shared filter for fstring, compiling it if no other listener
+ * uses it yet. *filterp is set to NULL if fstring is empty. Returns FALSE
+ * and sets err_msg if the filter is invalid.
+ */
+static gboolean
+tap_filter_get(const char *fstring, tap_filter_t **filterp, gchar **err_msg)
+{
+	tap_filter_t *tf;
+	dfilter_t *code=NULL;
+
+	for(tf=tap_filter_list;tf;tf=tf->next){
+		if(strcmp(tf->fstring, fstring)==0){
+			tf->refcount++;
+			*filterp=tf;
+			return TRUE;
+		}
+	}
+
+	if(!dfilter_compile(fstring, &code, err_msg)){
+		*filterp=NULL;
+		return FALSE;
+	}
+	if(!code){
+		/* Empty filter, matching all packets */
+		*filterp=NULL;
+		return TRUE;
+	}
+
+	tf=g_new0(tap_filter_t, 1);
+	tf->fstring=g_strdup(fstring);
+	tf->code=code;
+	tf->refcount=1;
+	tf->next=tap_filter_list;
+	tap_filter_list=tf;
+
+	*filterp=tf;
+	return TRUE;
+}
+
+static void
+tap_filter_release(tap_filter_t *tf)
+{
+	tap_filter_t **tfp;
+
+	if(!tf || --tf->refcount){
+		return;
+	}
+
+	for(tfp=&tap_filter_list;*tfp;tfp=&(*tfp)->next){
+		if(*tfp==tf){
+			*tfp=tf->next;
+			break;
+		}
+	}
+	dfilter_free(tf->code);
+	g_free(tf->fstring);
+	g_free(tf);
+}
+
 static void
 free_tap_listener(tap_listener_t *tl)
 {
@@ -515,7 +607,7 @@ free_tap_listener(tap_listener_t *tl)
 	if (tl->finish) {
 		tl->finish(tl->tapdata);
 	}
-	dfilter_free(tl->code);
+	tap_filter_release(tl->filter);
 	g_free(tl->fstring);
 	g_free(tl);
 }
@@ -533,7 +625,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 {
 	tap_listener_t *tl;
 	int tap_id;
-	dfilter_t *code=NULL;
+	tap_filter_t *filter=NULL;
 	GString *error_string;
 	gchar *err_msg;
 
@@ -549,7 +641,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->failed=FALSE;
 	tl->flags=flags;
 	if(fstring){
-		if(!dfilter_compile(fstring, &code, &err_msg)){
+		if(!tap_filter_get(fstring, &filter, &err_msg)){
 			error_string = g_string_new("");
 			g_string_printf(error_string,
 			    "Filter \"%s\" is invalid - %s",
@@ -560,7 +652,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 		}
 	}
 	tl->fstring=g_strdup(fstring);
-	tl->code=code;
+	tl->filter=filter;
 
 	tl->tap_id=tap_id;
 	tl->tapdata=tapdata;
@@ -581,7 +673,7 @@ GString *
 set_tap_dfilter(void *tapdata, const char *fstring)
 {
 	tap_listener_t *tl=NULL,*tl2;
-	dfilter_t *code=NULL;
+	tap_filter_t *filter=NULL;
 	GString *error_string;
 	gchar *err_msg;
 
@@ -602,14 +694,12 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 	}
 
 	if(tl){
-		if(tl->code){
-			dfilter_free(tl->code);
-			tl->code=NULL;
-		}
+		tap_filter_release(tl->filter);
+		tl->filter=NULL;
 		tl->needs_redraw=TRUE;
 		g_free(tl->fstring);
 		if(fstring){
-			if(!dfilter_compile(fstring, &code, &err_msg)){
+			if(!tap_filter_get(fstring, &filter, &err_msg)){
 				tl->fstring=NULL;
 				error_string = g_string_new("");
 				g_string_printf(error_string,
@@ -620,7 +710,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 			}
 		}
 		tl->fstring=g_strdup(fstring);
-		tl->code=code;
+		tl->filter=filter;
 	}
 
 	return NULL;
@@ -632,26 +722,28 @@ void
 tap_listeners_dfilter_recompile(void)
 {
 	tap_listener_t *tl;
+	tap_filter_t *tf;
 	dfilter_t *code;
 	gchar *err_msg;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code){
-			dfilter_free(tl->code);
-			tl->code=NULL;
-		}
 		tl->needs_redraw=TRUE;
+	}
+
+	/* Filters are shared, so each distinct filter string is
+	   compiled only once. */
+	for(tf=tap_filter_list;tf;tf=tf->next){
+		dfilter_free(tf->code);
 		code=NULL;
-		if(tl->fstring){
-			if(!dfilter_compile(tl->fstring, &code, &err_msg)){
+		if(!dfilter_compile(tf->fstring, &code, &err_msg)){
+			g_free(err_msg);
+			err_msg = NULL;
+			/* Not valid, make a dfilter matching no packets */
+			if (!dfilter_compile("frame.number == 0", &code, &err_msg))
 				g_free(err_msg);
-				err_msg = NULL;
-				/* Not valid, make a dfilter matching no packets */
-				if (!dfilter_compile("frame.number == 0", &code, &err_msg))
-					g_free(err_msg);
-			}
 		}
-		tl->code=code;
+		tf->code=code;
+		tf->evaluated=FALSE;
 	}
 }
 
@@ -731,7 +823,7 @@ have_filtering_tap_listeners(void)
 	tap_listener_t *tl;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code)
+		if(tl->filter)
 			return TRUE;
 	}
 	return FALSE;
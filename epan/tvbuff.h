@@ -203,6 +203,11 @@ extern void tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member);
 /** Create an empty composite tvbuff. */
 WS_DLL_PUBLIC tvbuff_t *tvb_new_composite(void);
 
+/** Create an empty composite tvbuff that is not attached to the chain of
+ * its first member. It must be freed with tvb_free(), and its members
+ * must be kept around for as long as it's used. */
+extern tvbuff_t *tvb_new_composite_detached(void);
+
 /** Mark a composite tvbuff as initialized. No further appends or prepends
  * occur, data access can finally happen after this finalization. */
 WS_DLL_PUBLIC void tvb_composite_finalize(tvbuff_t *tvb);
@@ -16,14 +16,18 @@
 #include "proto.h"	/* XXX - only used for DISSECTOR_ASSERT, probably a new header file? */
 
 typedef struct {
-	GSList		*tvbs;
+	GQueue		tvbs;
 
-	/* Used for quick testing to see if this
-	 * is the tvbuff that a COMPOSITE is
-	 * interested in. */
+	/* Filled in by tvb_composite_finalize(), so that the member
+	 * containing an offset can be found with a binary search. */
+	tvbuff_t	**members;
+	guint		num_members;
 	guint		*start_offsets;
 	guint		*end_offsets;
 
+	/* Not attached to the chain of its first member */
+	gboolean	detached;
+
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -38,8 +42,9 @@ composite_free(tvbuff_t *tvb)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	g_slist_free(composite->tvbs);
+	g_queue_clear(&composite->tvbs);
 
+	g_free(composite->members);
 	g_free(composite->start_offsets);
 	g_free(composite->end_offsets);
 	g_free((gpointer)tvb->real_data);
@@ -51,36 +56,48 @@ composite_offset(const tvbuff_t *tvb _U_, const guint counter)
 	return counter;
 }
 
+/*
+ * Find the index of the member that contains abs_offset; returns
+ * num_members if abs_offset is at or past the end of the composite.
+ */
+static guint
+composite_find_member(const tvb_comp_t *composite, guint abs_offset)
+{
+	guint low = 0, high = composite->num_members;
+
+	while (low < high) {
+		guint mid = low + (high - low) / 2;
+
+		if (abs_offset <= composite->end_offsets[mid])
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return low;
+}
+
 static const guint8*
 composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return "";
 	}
+	member_tvb = composite->members[i];
 
 	member_offset = abs_offset - composite->start_offsets[i];
 
@@ -108,63 +125,93 @@ composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_lengt
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	guint8 *target = (guint8 *) _target;
 
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
-	/* Maybe the range specified by offset/length
-	 * is contiguous inside one of the member tvbuffs */
-	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	composite = &composite_tvb->composite;
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
-	member_offset = abs_offset - composite->start_offsets[i];
-
-	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
-		DISSECTOR_ASSERT(!tvb->real_data);
-		return tvb_memcpy(member_tvb, target, member_offset, abs_length);
-	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
-		member_length = tvb_captured_length_remaining(member_tvb, member_offset);
+	/* Copy the part that's in each member tvb in turn; a reassembled
+	 * PDU can have thousands of them, so don't recurse. */
+	while (abs_length > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = MIN(abs_length, (guint)tvb_captured_length_remaining(member_tvb, member_offset));
 
 		/* composite_memcpy() can't handle a member_length of zero. */
 		DISSECTOR_ASSERT(member_length > 0);
 
 		tvb_memcpy(member_tvb, target, member_offset, member_length);
-		abs_offset	+= member_length;
-		abs_length	-= member_length;
+		target     += member_length;
+		abs_offset += member_length;
+		abs_length -= member_length;
+		i++;
+	}
 
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
-		}
+	return _target;
+}
 
-		return target;
+static gint
+composite_find_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, guint8 needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    i;
+	guint	    member_offset, member_length;
+	gint	    result;
+
+	/* Search each member in place, rather than making the whole
+	 * composite contiguous as tvb_get_ptr() would. */
+	for (i = composite_find_member(composite, abs_offset);
+	    limit > 0 && i < composite->num_members; i++) {
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = MIN(limit, composite->end_offsets[i] - abs_offset + 1);
+
+		result = tvb_find_guint8(composite->members[i], member_offset, member_length, needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit -= member_length;
 	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	return -1;
+}
+
+static gint
+composite_pbrk_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    i;
+	guint	    member_offset, member_length;
+	gint	    result;
+
+	for (i = composite_find_member(composite, abs_offset);
+	    limit > 0 && i < composite->num_members; i++) {
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = MIN(limit, composite->end_offsets[i] - abs_offset + 1);
+
+		result = tvb_ws_mempbrk_pattern_guint8(composite->members[i], member_offset, member_length, pattern, found_needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit -= member_length;
+	}
+
+	return -1;
 }
 
 static const struct tvb_ops tvb_composite_ops = {
@@ -174,8 +221,8 @@ static const struct tvb_ops tvb_composite_ops = {
 	composite_offset,     /* offset */
 	composite_get_ptr,    /* get_ptr */
 	composite_memcpy,     /* memcpy */
-	NULL,                 /* find_guint8 XXX */
-	NULL,                 /* pbrk_guint8 XXX */
+	composite_find_guint8, /* find_guint8 */
+	composite_pbrk_guint8, /* pbrk_guint8 */
 	NULL,                 /* clone */
 };
 
@@ -198,9 +245,32 @@ tvb_new_composite(void)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	composite->tvbs		 = NULL;
+	g_queue_init(&composite->tvbs);
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
 	composite->start_offsets = NULL;
 	composite->end_offsets	 = NULL;
+	composite->detached	 = FALSE;
+
+	return tvb;
+}
+
+/*
+ * Detached composite TVB
+ *
+ * Like tvb_new_composite, but the composite TVB is not attached to the
+ * chain of its first member; this is for composites that outlive the
+ * chain their members were created in, such as reassembled data.  The
+ * caller MUST free it with tvb_free, and MUST keep all of its members
+ * alive for as long as it is in use.
+ */
+tvbuff_t *
+tvb_new_composite_detached(void)
+{
+	tvbuff_t *tvb = tvb_new_composite();
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+
+	composite_tvb->composite.detached = TRUE;
 
 	return tvb;
 }
@@ -220,11 +290,11 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	DISSECTOR_ASSERT(member->length);
 
 	composite       = &composite_tvb->composite;
-	composite->tvbs = g_slist_append(composite->tvbs, member);
+	g_queue_push_tail(&composite->tvbs, member);
 
 	/* Attach the composite TVB to the first TVB only. */
-	if (!composite->tvbs->next) {
-		tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb);
+	if (!composite->detached && composite->tvbs.length == 1) {
+		tvb_add_to_chain(member, tvb);
 	}
 }
 
@@ -243,11 +313,11 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 	DISSECTOR_ASSERT(member->length);
 
 	composite       = &composite_tvb->composite;
-	composite->tvbs = g_slist_prepend(composite->tvbs, member);
+	g_queue_push_head(&composite->tvbs, member);
 
 	/* Attach the composite TVB to the first TVB only. */
-	if (!composite->tvbs->next) {
-		tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb);
+	if (!composite->detached && composite->tvbs.length == 1) {
+		tvb_add_to_chain(member, tvb);
 	}
 }
 
@@ -255,7 +325,7 @@ void
 tvb_composite_finalize(tvbuff_t *tvb)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	GSList	   *slist;
+	GList	   *list;
 	guint	    num_members;
 	tvbuff_t   *member_tvb;
 	tvb_comp_t *composite;
@@ -268,7 +338,7 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	DISSECTOR_ASSERT(tvb->contained_length == 0);
 
 	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
+	num_members = composite->tvbs.length;
 
 	/* Dissectors should not create composite TVBs if they're not going to
 	 * put at least one TVB in them.
@@ -276,12 +346,15 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	 */
 	DISSECTOR_ASSERT(num_members);
 
+	composite->members = g_new(tvbuff_t *, num_members);
+	composite->num_members = num_members;
 	composite->start_offsets = g_new(guint, num_members);
 	composite->end_offsets = g_new(guint, num_members);
 
-	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
+	for (list = composite->tvbs.head; list != NULL; list = list->next) {
 		DISSECTOR_ASSERT((guint) i < num_members);
-		member_tvb = (tvbuff_t *)slist->data;
+		member_tvb = (tvbuff_t *)list->data;
+		composite->members[i] = member_tvb;
 		composite->start_offsets[i] = tvb->length;
 		tvb->length += member_tvb->length;
 		tvb->reported_length += member_tvb->reported_length;
@@ -10,8 +10,17 @@
  */
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
+#include <wsutil/bits_ctz.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WMEM_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "wmem_core.h"
 #include "wmem_list.h"
 #include "wmem_map.h"
@@ -19,6 +28,7 @@
 #include "wmem_user_cb.h"
 
 static guint32 x; /* Used for universal integer hashing (see the HASH macro) */
+static guint64 x64; /* The same, for open addressing (see the FLAT_HASH macro) */
 
 /* Used for the wmem_strong_hash() function */
 static guint32 preseed;
@@ -31,6 +41,9 @@ wmem_init_hashing(void)
     if (G_UNLIKELY(x == 0))
         x = 1;
 
+    /* Odd, so that it is invertible and no hash bits are lost */
+    x64 = ((guint64)g_random_int() << 32) | g_random_int() | 1;
+
     preseed  = g_random_int();
     postseed = g_random_int();
 }
@@ -41,6 +54,14 @@ typedef struct _wmem_map_item_t {
     struct _wmem_map_item_t *next;
 } wmem_map_item_t;
 
+/* A slot of an open addressing map. order is the item's index in the
+ * array that records the order the items were inserted in. */
+typedef struct _wmem_map_flat_slot_t {
+    const void *key;
+    void *value;
+    guint32 order;
+} wmem_map_flat_slot_t;
+
 struct _wmem_map_t {
     guint count; /* number of items stored */
 
@@ -52,6 +73,17 @@ struct _wmem_map_t {
 
     wmem_map_item_t **table;
 
+    /* Open addressing maps (see wmem_map_new_flat) use these instead of
+     * table. ctrl has one byte for each slot: FLAT_EMPTY, FLAT_DELETED, or
+     * 7 bits of the hash of the key in the slot. order has the slot of each
+     * item in the order they were inserted, or FLAT_REMOVED for items that
+     * have since been removed. */
+    gboolean               flat;
+    guint8                *ctrl;
+    wmem_map_flat_slot_t  *slots;
+    guint32               *order;
+    guint                  order_used; /* including removed items */
+
     GHashFunc  hash_func;
     GEqualFunc eql_func;
 
@@ -76,6 +108,25 @@ struct _wmem_map_t {
 #define HASH(MAP, KEY) \
     ((guint32)(((MAP)->hash_func(KEY) * x) >> (32 - (MAP)->capacity)))
 
+/* Open addressing maps look for keys a group of slots at a time, comparing
+ * the control bytes of a whole group at once. They are rebuilt once the
+ * order array, including removed items, is 7/8 full, so every probe
+ * sequence ends at an empty slot. */
+#define FLAT_GROUP_WIDTH 16
+#define FLAT_EMPTY       0x80
+#define FLAT_DELETED     0xFE
+#define FLAT_REMOVED     G_MAXUINT32
+#define WMEM_MAP_FLAT_DEFAULT_CAPACITY 5
+
+#define FLAT_ORDER_CAPACITY(MAP) (CAPACITY(MAP) - CAPACITY(MAP) / 8)
+
+/* The top 7 bits of the hash go in the control byte, and the bits below
+ * them choose the group the probe sequence starts at. */
+#define FLAT_HASH(MAP, KEY) ((guint64)(MAP)->hash_func(KEY) * x64)
+#define FLAT_H2(HASH) ((guint8)((HASH) >> 57))
+#define FLAT_GROUP(MAP, HASH) \
+    ((size_t)((HASH) >> (57 - ((MAP)->capacity - 4))) & (CAPACITY(MAP) / FLAT_GROUP_WIDTH - 1))
+
 static void
 wmem_map_init_table(wmem_map_t *map)
 {
@@ -98,6 +149,20 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->data_allocator = allocator;
     map->count = 0;
     map->table = NULL;
+    map->flat = FALSE;
+    map->ctrl = NULL;
+
+    return map;
+}
+
+wmem_map_t *
+wmem_map_new_flat(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new(allocator, hash_func, eql_func);
+    map->flat = TRUE;
 
     return map;
 }
@@ -110,6 +175,7 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
 
     map->count = 0;
     map->table = NULL;
+    map->ctrl = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(map->metadata_allocator, map->metadata_scope_cb_id);
@@ -144,6 +210,8 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     map->data_allocator = data_scope;
     map->count = 0;
     map->table = NULL;
+    map->flat = FALSE;
+    map->ctrl = NULL;
 
     map->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_map_destroy_cb, map);
     map->data_scope_cb_id  = wmem_register_callback(data_scope, wmem_map_reset_cb, map);
@@ -151,6 +219,241 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     return map;
 }
 
+wmem_map_t *
+wmem_map_new_flat_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new_autoreset(metadata_scope, data_scope, hash_func, eql_func);
+    map->flat = TRUE;
+
+    return map;
+}
+
+/* Returns a bitmask of the bytes of a group of control bytes that are equal
+ * to the given byte. */
+static inline guint32
+wmem_map_flat_match(const guint8 *group, guint8 byte)
+{
+#ifdef WMEM_MAP_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+
+    return (guint32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#else
+    guint32 mask = 0;
+    int i;
+
+    for (i = 0; i < FLAT_GROUP_WIDTH; i++) {
+        if (group[i] == byte) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+/* Returns a bitmask of the empty or deleted bytes of a group of control
+ * bytes, which are the ones with the top bit set. */
+static inline guint32
+wmem_map_flat_match_free(const guint8 *group)
+{
+#ifdef WMEM_MAP_SSE2
+    return (guint32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+    guint32 mask = 0;
+    int i;
+
+    for (i = 0; i < FLAT_GROUP_WIDTH; i++) {
+        if (group[i] & 0x80) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+/* Returns the slot holding the key, or -1 if it isn't in the map. */
+static gssize
+wmem_map_flat_find(wmem_map_t *map, const void *key)
+{
+    guint64 hash;
+    size_t  group, probe;
+    guint32 mask;
+    guint8  h2;
+
+    if (map->ctrl == NULL) {
+        return -1;
+    }
+
+    hash  = FLAT_HASH(map, key);
+    h2    = FLAT_H2(hash);
+    group = FLAT_GROUP(map, hash);
+
+    for (probe = 1; ; probe++) {
+        const guint8 *ctrl = &map->ctrl[group * FLAT_GROUP_WIDTH];
+
+        mask = wmem_map_flat_match(ctrl, h2);
+        while (mask) {
+            size_t slot = group * FLAT_GROUP_WIDTH + ws_ctz(mask);
+
+            if (map->eql_func(key, map->slots[slot].key)) {
+                return (gssize)slot;
+            }
+            mask &= mask - 1;
+        }
+        if (wmem_map_flat_match(ctrl, FLAT_EMPTY)) {
+            return -1;
+        }
+        /* Triangular probing visits every group of a power of 2 sized table */
+        group = (group + probe) & (CAPACITY(map) / FLAT_GROUP_WIDTH - 1);
+    }
+}
+
+/* Puts an item in the first empty or deleted slot of its probe sequence. */
+static void
+wmem_map_flat_place(wmem_map_t *map, const void *key, void *value, guint32 order)
+{
+    guint64 hash;
+    size_t  group, probe, slot;
+    guint32 mask;
+
+    hash  = FLAT_HASH(map, key);
+    group = FLAT_GROUP(map, hash);
+
+    for (probe = 1; ; probe++) {
+        mask = wmem_map_flat_match_free(&map->ctrl[group * FLAT_GROUP_WIDTH]);
+        if (mask) {
+            break;
+        }
+        group = (group + probe) & (CAPACITY(map) / FLAT_GROUP_WIDTH - 1);
+    }
+
+    slot = group * FLAT_GROUP_WIDTH + ws_ctz(mask);
+    map->ctrl[slot]        = FLAT_H2(hash);
+    map->slots[slot].key   = key;
+    map->slots[slot].value = value;
+    map->slots[slot].order = order;
+    map->order[order]      = (guint32)slot;
+}
+
+static void
+wmem_map_flat_alloc(wmem_map_t *map)
+{
+    map->ctrl  = (guint8 *)wmem_alloc(map->data_allocator, CAPACITY(map));
+    map->slots = wmem_alloc_array(map->data_allocator, wmem_map_flat_slot_t, CAPACITY(map));
+    memset(map->ctrl, FLAT_EMPTY, CAPACITY(map));
+}
+
+/* Rebuilds the table with the given capacity, dropping removed items and
+ * deleted slots. The items keep their order. */
+static void
+wmem_map_flat_rebuild(wmem_map_t *map, size_t capacity)
+{
+    guint8               *old_ctrl  = map->ctrl;
+    wmem_map_flat_slot_t *old_slots = map->slots;
+    size_t                old_cap   = CAPACITY(map);
+    guint                 i, used;
+
+    map->capacity = capacity;
+    wmem_map_flat_alloc(map);
+    if (FLAT_ORDER_CAPACITY(map) > map->order_used) {
+        map->order = (guint32 *)wmem_realloc(map->data_allocator, map->order,
+                FLAT_ORDER_CAPACITY(map) * sizeof(guint32));
+    }
+
+    if (map->count == map->order_used) {
+        /* Nothing was removed, so the items keep their places in the order
+         * array, and the old slots can be read in order */
+        for (i = 0; i < old_cap; i++) {
+            if (!(old_ctrl[i] & 0x80)) {
+                wmem_map_flat_place(map, old_slots[i].key, old_slots[i].value, old_slots[i].order);
+            }
+        }
+    } else {
+        for (i = 0, used = 0; i < map->order_used; i++) {
+            if (map->order[i] != FLAT_REMOVED) {
+                wmem_map_flat_slot_t *old = &old_slots[map->order[i]];
+
+                wmem_map_flat_place(map, old->key, old->value, used++);
+            }
+        }
+        map->order_used = used;
+    }
+
+    wmem_free(map->data_allocator, old_ctrl);
+    wmem_free(map->data_allocator, old_slots);
+}
+
+static void *
+wmem_map_flat_insert(wmem_map_t *map, const void *key, void *value)
+{
+    gssize slot;
+    void  *old_val;
+
+    /* Make sure we have a table */
+    if (map->ctrl == NULL) {
+        map->count      = 0;
+        map->order_used = 0;
+        map->capacity   = WMEM_MAP_FLAT_DEFAULT_CAPACITY;
+        wmem_map_flat_alloc(map);
+        map->order      = wmem_alloc_array(map->data_allocator, guint32, FLAT_ORDER_CAPACITY(map));
+    }
+
+    slot = wmem_map_flat_find(map, key);
+    if (slot >= 0) {
+        /* replace and return old value for this key */
+        old_val = map->slots[slot].value;
+        map->slots[slot].value = value;
+        return old_val;
+    }
+
+    if (map->order_used == FLAT_ORDER_CAPACITY(map)) {
+        /* Double the size if at least half the items are still in the
+         * map, otherwise just drop the removed ones */
+        if (map->count >= map->order_used / 2) {
+            wmem_map_flat_rebuild(map, map->capacity + 1);
+        } else {
+            wmem_map_flat_rebuild(map, map->capacity);
+        }
+    }
+
+    wmem_map_flat_place(map, key, value, map->order_used++);
+    map->count++;
+
+    return NULL;
+}
+
+static void *
+wmem_map_flat_remove(wmem_map_t *map, const void *key, gboolean *found)
+{
+    gssize slot;
+    const guint8 *group;
+
+    slot = wmem_map_flat_find(map, key);
+    if (slot < 0) {
+        *found = FALSE;
+        return NULL;
+    }
+
+    map->order[map->slots[slot].order] = FLAT_REMOVED;
+
+    /* If the group has an empty slot, no probe sequence has gone on past
+     * it, so this slot can be made empty rather than deleted */
+    group = &map->ctrl[slot & ~(gssize)(FLAT_GROUP_WIDTH - 1)];
+    map->ctrl[slot] = wmem_map_flat_match(group, FLAT_EMPTY) ? FLAT_EMPTY : FLAT_DELETED;
+
+    map->count--;
+    if (map->count == 0) {
+        /* Start over, rather than filling up with removed items */
+        map->order_used = 0;
+        memset(map->ctrl, FLAT_EMPTY, CAPACITY(map));
+    }
+
+    *found = TRUE;
+    return map->slots[slot].value;
+}
+
 static inline void
 wmem_map_grow(wmem_map_t *map)
 {
@@ -189,6 +492,10 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
     wmem_map_item_t **item;
     void *old_val;
 
+    if (map->flat) {
+        return wmem_map_flat_insert(map, key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
@@ -231,6 +538,10 @@ wmem_map_contains(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map->flat) {
+        return wmem_map_flat_find(map, key) >= 0;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -255,6 +566,12 @@ wmem_map_lookup(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map->flat) {
+        gssize slot = wmem_map_flat_find(map, key);
+
+        return slot >= 0 ? map->slots[slot].value : NULL;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -279,6 +596,21 @@ wmem_map_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key
 {
     wmem_map_item_t *item;
 
+    if (map->flat) {
+        gssize slot = wmem_map_flat_find(map, key);
+
+        if (slot < 0) {
+            return FALSE;
+        }
+        if (orig_key) {
+            *orig_key = map->slots[slot].key;
+        }
+        if (value) {
+            *value = map->slots[slot].value;
+        }
+        return TRUE;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -310,6 +642,12 @@ wmem_map_remove(wmem_map_t *map, const void *key)
     wmem_map_item_t **item, *tmp;
     void *value;
 
+    if (map->flat) {
+        gboolean found;
+
+        return wmem_map_flat_remove(map, key, &found);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -341,6 +679,13 @@ wmem_map_steal(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
 
+    if (map->flat) {
+        gboolean found;
+
+        wmem_map_flat_remove(map, key, &found);
+        return found;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -372,6 +717,18 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
+    if (map->flat) {
+        /* prepend from the end so that the list is in insertion order */
+        if (map->ctrl != NULL) {
+            for (i = map->order_used; i > 0; i--) {
+                if (map->order[i - 1] != FLAT_REMOVED) {
+                    wmem_list_prepend(list, (void*)map->slots[map->order[i - 1]].key);
+                }
+            }
+        }
+        return list;
+    }
+
     if (map->table != NULL) {
         capacity = CAPACITY(map);
 
@@ -394,6 +751,20 @@ wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
     wmem_map_item_t *cur;
     unsigned i;
 
+    if (map->flat) {
+        /* Items are visited in insertion order */
+        if (map->ctrl != NULL) {
+            for (i = 0; i < map->order_used; i++) {
+                if (map->order[i] != FLAT_REMOVED) {
+                    wmem_map_flat_slot_t *slot = &map->slots[map->order[i]];
+
+                    foreach_func((gpointer)slot->key, slot->value, user_data);
+                }
+            }
+        }
+        return;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return;
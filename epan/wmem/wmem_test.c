@@ -903,8 +903,13 @@ check_val_map(gpointer key _U_, gpointer val, gpointer user_data)
     g_assert(val == user_data);
 }
 
+typedef wmem_map_t *(*wmem_map_new_func)(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func);
+typedef wmem_map_t *(*wmem_map_new_autoreset_func)(wmem_allocator_t *metadata_scope,
+        wmem_allocator_t *data_scope, GHashFunc hash_func, GEqualFunc eql_func);
+
 static void
-wmem_test_map(void)
+wmem_test_map_common(wmem_map_new_func map_new, wmem_map_new_autoreset_func map_new_autoreset)
 {
     wmem_allocator_t   *allocator, *extra_allocator;
     wmem_map_t       *map;
@@ -919,7 +924,7 @@ wmem_test_map(void)
     extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
 
     /* insertion, lookup and removal of simple integer keys */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
 
     for (i=0; i<CONTAINER_ITERS; i++) {
@@ -957,7 +962,7 @@ wmem_test_map(void)
     wmem_free_all(allocator);
 
     /* test auto-reset functionality */
-    map = wmem_map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    map = map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
@@ -973,7 +978,7 @@ wmem_test_map(void)
     }
     wmem_free_all(allocator);
 
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = map_new(allocator, wmem_str_hash, g_str_equal);
     g_assert(map);
 
     /* string keys and for-each */
@@ -991,7 +996,7 @@ wmem_test_map(void)
     }
 
     /* test foreach */
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = map_new(allocator, wmem_str_hash, g_str_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
@@ -1000,7 +1005,7 @@ wmem_test_map(void)
     wmem_map_foreach(map, check_val_map, GINT_TO_POINTER(2));
 
     /* test size */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
     g_assert(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
@@ -1011,6 +1016,160 @@ wmem_test_map(void)
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_map(void)
+{
+    wmem_test_map_common(wmem_map_new, wmem_map_new_autoreset);
+}
+
+static void
+check_order_map(gpointer key, gpointer val _U_, gpointer user_data)
+{
+    int *last = (int *)user_data;
+
+    g_assert_cmpint(GPOINTER_TO_INT(key), >, *last);
+    *last = GPOINTER_TO_INT(key);
+}
+
+static void
+wmem_test_map_flat(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    wmem_list_t        *keys;
+    wmem_list_frame_t  *frame;
+    gboolean           *present;
+    unsigned int        i, count;
+    int                 last;
+
+    wmem_test_map_common(wmem_map_new_flat, wmem_map_new_flat_autoreset);
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* items are visited in insertion order, across growth and removal */
+    map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+    for (i=1; i<=CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+    }
+    for (i=1; i<=CONTAINER_ITERS; i+=3) {
+        g_assert(wmem_map_steal(map, GINT_TO_POINTER(i)) == TRUE);
+        g_assert(wmem_map_steal(map, GINT_TO_POINTER(i)) == FALSE);
+    }
+    last = 0;
+    wmem_map_foreach(map, check_order_map, &last);
+    g_assert_cmpint(last, ==, CONTAINER_ITERS - 1);
+
+    keys = wmem_map_get_keys(allocator, map);
+    g_assert_cmpuint(wmem_list_count(keys), ==, wmem_map_size(map));
+    last = 0;
+    for (frame = wmem_list_head(keys); frame; frame = wmem_list_frame_next(frame)) {
+        g_assert_cmpint(GPOINTER_TO_INT(wmem_list_frame_data(frame)), >, last);
+        last = GPOINTER_TO_INT(wmem_list_frame_data(frame));
+    }
+    wmem_free_all(allocator);
+
+    /* random insertions and removals, checked against a shadow array */
+    map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+    present = wmem_alloc0_array(allocator, gboolean, CONTAINER_ITERS);
+    count = 0;
+    for (i=0; i<CONTAINER_ITERS*10; i++) {
+        unsigned int key = g_test_rand_int_range(0, CONTAINER_ITERS);
+
+        if (present[key]) {
+            g_assert(wmem_map_remove(map, GINT_TO_POINTER(key)) == GINT_TO_POINTER(key + 1));
+            present[key] = FALSE;
+            count--;
+        } else {
+            g_assert(wmem_map_insert(map, GINT_TO_POINTER(key), GINT_TO_POINTER(key + 1)) == NULL);
+            present[key] = TRUE;
+            count++;
+        }
+        g_assert_cmpuint(wmem_map_size(map), ==, count);
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert(wmem_map_lookup(map, GINT_TO_POINTER(i)) ==
+                (present[i] ? GINT_TO_POINTER(i + 1) : NULL));
+    }
+
+    wmem_destroy_allocator(allocator);
+}
+
+/* NOTE: You have to run "wmem_test -m perf --verbose" to see results. */
+static void
+wmem_test_mapperf(void)
+{
+#define MAP_PERF_COUNT (1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    wmem_map_new_func   map_new[] = { wmem_map_new, wmem_map_new_flat };
+    const char         *map_name[] = { "chained", "flat" };
+    const char         *keys_name[] = { "sequential", "random" };
+    guint32            *keys[2];
+    void * volatile     ret;
+    unsigned int        i, k, m;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    /* Even keys, so that the odd key next to each one is never in the map;
+     * the random ones may repeat, which makes some inserts replacements. */
+    keys[0] = g_new(guint32, MAP_PERF_COUNT);
+    keys[1] = g_new(guint32, MAP_PERF_COUNT);
+    for (i = 0; i < MAP_PERF_COUNT; i++) {
+        keys[0][i] = i * 2;
+        keys[1][i] = g_test_rand_int() & ~1U;
+    }
+
+    for (k = 0; k < G_N_ELEMENTS(keys); k++) {
+        for (m = 0; m < G_N_ELEMENTS(map_new); m++) {
+            map = map_new[m](allocator, g_direct_hash, g_direct_equal);
+
+            RESOURCE_USAGE_START;
+            for (i = 0; i < MAP_PERF_COUNT; i++) {
+                wmem_map_insert(map, GUINT_TO_POINTER(keys[k][i]), GUINT_TO_POINTER(i));
+            }
+            RESOURCE_USAGE_END;
+            g_test_minimized_result(utime_ms + stime_ms,
+                "%s map, %d %s inserts: u %.3f ms s %.3f ms",
+                map_name[m], MAP_PERF_COUNT, keys_name[k], utime_ms, stime_ms);
+
+            RESOURCE_USAGE_START;
+            for (i = 0; i < MAP_PERF_COUNT; i++) {
+                ret = wmem_map_lookup(map, GUINT_TO_POINTER(keys[k][i]));
+            }
+            RESOURCE_USAGE_END;
+            g_test_minimized_result(utime_ms + stime_ms,
+                "%s map, %d %s successful lookups: u %.3f ms s %.3f ms",
+                map_name[m], MAP_PERF_COUNT, keys_name[k], utime_ms, stime_ms);
+
+            RESOURCE_USAGE_START;
+            for (i = 0; i < MAP_PERF_COUNT; i++) {
+                ret = wmem_map_lookup(map, GUINT_TO_POINTER(keys[k][i] + 1));
+            }
+            RESOURCE_USAGE_END;
+            g_test_minimized_result(utime_ms + stime_ms,
+                "%s map, %d %s failed lookups: u %.3f ms s %.3f ms",
+                map_name[m], MAP_PERF_COUNT, keys_name[k], utime_ms, stime_ms);
+
+            RESOURCE_USAGE_START;
+            for (i = 0; i < MAP_PERF_COUNT; i++) {
+                ret = wmem_map_remove(map, GUINT_TO_POINTER(keys[k][i]));
+            }
+            RESOURCE_USAGE_END;
+            g_test_minimized_result(utime_ms + stime_ms,
+                "%s map, %d %s removals: u %.3f ms s %.3f ms",
+                map_name[m], MAP_PERF_COUNT, keys_name[k], utime_ms, stime_ms);
+
+            wmem_free_all(allocator);
+        }
+    }
+    (void)ret;
+
+    g_free(keys[0]);
+    g_free(keys[1]);
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1170,8 +1329,12 @@ wmem_test_strbuf(void)
     wmem_destroy_allocator(allocator);
 }
 
+typedef wmem_tree_t *(*wmem_tree_new_func)(wmem_allocator_t *allocator);
+typedef wmem_tree_t *(*wmem_tree_new_autoreset_func)(wmem_allocator_t *metadata_scope,
+        wmem_allocator_t *data_scope);
+
 static void
-wmem_test_tree(void)
+wmem_test_tree_common(wmem_tree_new_func tree_new, wmem_tree_new_autoreset_func tree_new_autoreset)
 {
     wmem_allocator_t   *allocator, *extra_allocator;
     wmem_tree_t        *tree;
@@ -1187,7 +1350,7 @@ wmem_test_tree(void)
     allocator       = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
     extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     g_assert(tree);
     g_assert(wmem_tree_is_empty(tree));
 
@@ -1204,7 +1367,7 @@ wmem_test_tree(void)
     g_assert(wmem_tree_count(tree) == CONTAINER_ITERS);
     wmem_free_all(allocator);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         guint32 rand_int;
         do {
@@ -1217,7 +1380,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test auto-reset functionality */
-    tree = wmem_tree_new_autoreset(allocator, extra_allocator);
+    tree = tree_new_autoreset(allocator, extra_allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         g_assert(wmem_tree_lookup32(tree, i) == NULL);
         wmem_tree_insert32(tree, i, GINT_TO_POINTER(i));
@@ -1233,7 +1396,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test array key functionality */
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     key_count = g_random_int_range(1, WMEM_TREE_MAX_KEY_COUNT);
     for (j=0; j<key_count; j++) {
         keys[j].length = g_random_int_range(1, WMEM_TREE_MAX_KEY_LEN);
@@ -1249,7 +1412,7 @@ wmem_test_tree(void)
     }
     wmem_free_all(allocator);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     keys[0].length = 1;
     keys[0].key    = wmem_new(allocator, guint32);
     *(keys[0].key) = 0;
@@ -1271,7 +1434,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test string key functionality */
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
         wmem_tree_insert_string(tree, str_key, GINT_TO_POINTER(i), 0);
@@ -1280,7 +1443,7 @@ wmem_test_tree(void)
     }
     wmem_free_all(allocator);
 
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
         wmem_tree_insert_string(tree, str_key, GINT_TO_POINTER(i),
@@ -1291,7 +1454,7 @@ wmem_test_tree(void)
     wmem_free_all(allocator);
 
     /* test for-each functionality */
-    tree = wmem_tree_new(allocator);
+    tree = tree_new(allocator);
     expected_user_data = GINT_TO_POINTER(g_test_rand_int());
     for (i=0; i<CONTAINER_ITERS; i++) {
         gint tmp;
@@ -1330,6 +1493,225 @@ wmem_test_tree(void)
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_tree(void)
+{
+    wmem_test_tree_common(wmem_tree_new, wmem_tree_new_autoreset);
+}
+
+static gboolean
+wmem_test_tree_order_cb(const void *key, void *value _U_, void *userdata)
+{
+    guint32 *prev = (guint32 *)userdata;
+
+    g_assert(GPOINTER_TO_UINT(key) > *prev || (*prev == 0 && GPOINTER_TO_UINT(key) == 0));
+    *prev = GPOINTER_TO_UINT(key);
+    cb_called_count++;
+    return FALSE;
+}
+
+static void
+wmem_test_tree_btree(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_tree_t        *tree, *rb_tree;
+    guint32             i, key, prev;
+    guint32            *keys;
+    wmem_tree_key_t     array_key[3];
+    guint32             array_key_1, array_key_2;
+
+    wmem_test_tree_common(wmem_tree_new_btree, wmem_tree_new_btree_autoreset);
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* random keys, checked against a red/black tree */
+    tree    = wmem_tree_new_btree(allocator);
+    rb_tree = wmem_tree_new(allocator);
+    keys    = wmem_alloc_array(allocator, guint32, CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        /* a small range, to get duplicates */
+        keys[i] = g_test_rand_int_range(0, CONTAINER_ITERS * 4);
+        wmem_tree_insert32(tree, keys[i], GINT_TO_POINTER(i + 1));
+        wmem_tree_insert32(rb_tree, keys[i], GINT_TO_POINTER(i + 1));
+    }
+    wmem_strict_check_canaries(allocator);
+    g_assert(wmem_tree_count(tree) == wmem_tree_count(rb_tree));
+    for (key=0; key<CONTAINER_ITERS * 4 + 8; key++) {
+        g_assert(wmem_tree_lookup32(tree, key) == wmem_tree_lookup32(rb_tree, key));
+        g_assert(wmem_tree_lookup32_le(tree, key) == wmem_tree_lookup32_le(rb_tree, key));
+    }
+
+    /* removed keys are still found by wmem_tree_lookup32_le(), with a NULL
+     * value, just as in a red/black tree */
+    for (i=0; i<CONTAINER_ITERS; i+=3) {
+        g_assert(wmem_tree_remove32(tree, keys[i]) == wmem_tree_remove32(rb_tree, keys[i]));
+    }
+    for (key=0; key<CONTAINER_ITERS * 4 + 8; key++) {
+        g_assert(wmem_tree_lookup32(tree, key) == wmem_tree_lookup32(rb_tree, key));
+        g_assert(wmem_tree_lookup32_le(tree, key) == wmem_tree_lookup32_le(rb_tree, key));
+    }
+
+    /* wmem_tree_foreach() visits the keys in order */
+    prev = 0;
+    cb_called_count = 0;
+    wmem_tree_foreach(tree, wmem_test_tree_order_cb, &prev);
+    g_assert((guint)cb_called_count == wmem_tree_count(rb_tree));
+    wmem_free_all(allocator);
+
+    /* decreasing keys, at the ends of the key space */
+    tree = wmem_tree_new_btree(allocator);
+    g_assert(wmem_tree_lookup32_le(tree, G_MAXUINT32) == NULL);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_tree_insert32(tree, G_MAXUINT32 - i, GINT_TO_POINTER(i + 1));
+    }
+    wmem_tree_insert32(tree, 0, GINT_TO_POINTER(CONTAINER_ITERS + 1));
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert(wmem_tree_lookup32(tree, G_MAXUINT32 - i) == GINT_TO_POINTER(i + 1));
+    }
+    g_assert(wmem_tree_lookup32_le(tree, G_MAXUINT32 - CONTAINER_ITERS) ==
+            GINT_TO_POINTER(CONTAINER_ITERS + 1));
+    g_assert(wmem_tree_lookup32_le(tree, 0) == GINT_TO_POINTER(CONTAINER_ITERS + 1));
+    g_assert(wmem_tree_count(tree) == CONTAINER_ITERS + 1);
+    wmem_free_all(allocator);
+
+    /* array keys get B+tree subtrees, and strings can share the tree */
+    tree = wmem_tree_new_btree(allocator);
+    array_key[0].length = 1;
+    array_key[0].key    = &array_key_1;
+    array_key[1].length = 1;
+    array_key[1].key    = &array_key_2;
+    array_key[2].length = 0;
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        array_key_1 = i % 7;
+        array_key_2 = i * 2;
+        wmem_tree_insert32_array(tree, array_key, GINT_TO_POINTER(i + 1));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        array_key_1 = i % 7;
+        array_key_2 = i * 2;
+        g_assert(wmem_tree_lookup32_array(tree, array_key) == GINT_TO_POINTER(i + 1));
+        array_key_2 = i * 2 + 1;
+        g_assert(wmem_tree_lookup32_array(tree, array_key) == NULL);
+        g_assert(wmem_tree_lookup32_array_le(tree, array_key) == GINT_TO_POINTER(i + 1));
+    }
+    wmem_tree_insert_string(tree, "foo", GINT_TO_POINTER(1), 0);
+    g_assert(wmem_tree_lookup_string(tree, "foo", 0) == GINT_TO_POINTER(1));
+    g_assert(wmem_tree_count(tree) == CONTAINER_ITERS + 1);
+    wmem_strict_check_canaries(allocator);
+
+    wmem_tree_destroy(tree, FALSE, FALSE);
+    tree = wmem_tree_new_btree(NULL);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_tree_insert32(tree, i, g_malloc(1));
+    }
+    wmem_tree_destroy(tree, FALSE, TRUE);
+
+    wmem_destroy_allocator(allocator);
+}
+
+static guint64
+wmem_test_btree_size(const wmem_btree_node_t *node)
+{
+    guint64 size = sizeof(*node);
+    guint32 i;
+
+    if (!node->is_leaf) {
+        for (i = 0; i <= node->count; i++) {
+            size += wmem_test_btree_size(node->u.children[i]);
+        }
+    }
+    return size;
+}
+
+/* The size of the nodes of a tree, not counting allocator overhead */
+static double
+wmem_test_tree_bytes_per_key(wmem_tree_t *tree)
+{
+    if (tree->btree) {
+        return (double)wmem_test_btree_size(tree->btree) / wmem_tree_count(tree);
+    }
+    return sizeof(wmem_tree_node_t);
+}
+
+/* NOTE: You have to run "wmem_test -m perf --verbose" to see results. */
+static void
+wmem_test_treeperf(void)
+{
+#define TREE_PERF_COUNT (10 * 1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_tree_t        *tree;
+    wmem_tree_new_func  tree_new[] = { wmem_tree_new, wmem_tree_new_btree };
+    const char         *tree_name[] = { "red/black", "B+" };
+    guint32            *rand_keys;
+    void * volatile     ret;
+    unsigned int        i, t;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    /* Lookups of frame numbers that aren't in order, as when the user
+     * jumps around in the packet list */
+    rand_keys = g_new(guint32, TREE_PERF_COUNT);
+    for (i = 0; i < TREE_PERF_COUNT; i++) {
+        rand_keys[i] = g_test_rand_int_range(0, TREE_PERF_COUNT * 2);
+    }
+
+    for (t = 0; t < G_N_ELEMENTS(tree_new); t++) {
+        tree = tree_new[t](allocator);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_COUNT; i++) {
+            wmem_tree_insert32(tree, i * 2, GUINT_TO_POINTER(i + 1));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree, %d increasing inserts: u %.3f ms s %.3f ms, %.1f bytes of nodes per key",
+            tree_name[t], TREE_PERF_COUNT, utime_ms, stime_ms, wmem_test_tree_bytes_per_key(tree));
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_COUNT; i++) {
+            ret = wmem_tree_lookup32(tree, rand_keys[i]);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree, %d random lookups: u %.3f ms s %.3f ms", tree_name[t], TREE_PERF_COUNT, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_COUNT; i++) {
+            ret = wmem_tree_lookup32_le(tree, rand_keys[i]);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree, %d random lookup32_le: u %.3f ms s %.3f ms", tree_name[t], TREE_PERF_COUNT, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_COUNT; i++) {
+            ret = wmem_tree_lookup32_le(tree, i * 2 + 1);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree, %d sequential lookup32_le: u %.3f ms s %.3f ms", tree_name[t], TREE_PERF_COUNT, utime_ms, stime_ms);
+
+        wmem_free_all(allocator);
+
+        tree = tree_new[t](allocator);
+        RESOURCE_USAGE_START;
+        for (i = 0; i < TREE_PERF_COUNT; i++) {
+            wmem_tree_insert32(tree, rand_keys[i], GUINT_TO_POINTER(i + 1));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s tree, %d random inserts: u %.3f ms s %.3f ms, %.1f bytes of nodes per key",
+            tree_name[t], TREE_PERF_COUNT, utime_ms, stime_ms, wmem_test_tree_bytes_per_key(tree));
+
+        wmem_free_all(allocator);
+    }
+    (void)ret;
+
+    g_free(rand_keys);
+    wmem_destroy_allocator(allocator);
+}
+
 
 /* to be used as userdata in the callback wmem_test_itree_check_overlap_cb*/
 typedef struct wmem_test_itree_user_data {
@@ -1458,12 +1840,19 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
     g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_func("/wmem/datastruct/map_flat", wmem_test_map_flat);
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
     g_test_add_func("/wmem/datastruct/tree",   wmem_test_tree);
+    g_test_add_func("/wmem/datastruct/tree_btree", wmem_test_tree_btree);
     g_test_add_func("/wmem/datastruct/itree",  wmem_test_itree);
 
+    if (g_test_perf()) {
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_mapperf);
+        g_test_add_func("/wmem/datastruct/treeperf", wmem_test_treeperf);
+    }
+
     ret = g_test_run();
 
     wmem_cleanup();
@@ -44,6 +44,30 @@ typedef struct _wmem_tree_node_t wmem_tree_node_t;
 
 typedef struct _wmem_itree_node_t wmem_itree_node_t;
 
+/* The maximum number of keys in a B+tree node. */
+#define WMEM_BTREE_MAX_KEYS 32
+
+typedef struct _wmem_btree_node_t wmem_btree_node_t;
+
+/* A B+tree node. Interior nodes have count + 1 children; children[i] holds
+ * the keys less than keys[i], and children[i + 1] the keys greater than or
+ * equal to it. The entries themselves are in the leaves, which are linked
+ * in key order. */
+struct _wmem_btree_node_t {
+    guint32  count;
+    gboolean is_leaf;
+    guint32  keys[WMEM_BTREE_MAX_KEYS];
+
+    union {
+        struct {
+            void              *data[WMEM_BTREE_MAX_KEYS];
+            guint8             is_subtree[WMEM_BTREE_MAX_KEYS];
+            wmem_btree_node_t *next;
+        } leaf;
+        wmem_btree_node_t *children[WMEM_BTREE_MAX_KEYS + 1];
+    } u;
+};
+
 struct _wmem_tree_t {
     wmem_allocator_t *metadata_allocator;
     wmem_allocator_t *data_allocator;
@@ -52,6 +76,11 @@ struct _wmem_tree_t {
     guint             data_scope_cb_id;
 
     void (*post_rotation_cb)(wmem_tree_node_t *);
+
+    /* Trees created by wmem_tree_new_btree() keep their guint32 keys in a
+     * B+tree instead of in the red/black tree under root. */
+    gboolean           use_btree;
+    wmem_btree_node_t *btree;
 };
 
 typedef int (*compare_func)(const void *a, const void *b);
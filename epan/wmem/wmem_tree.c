@@ -206,6 +206,17 @@ wmem_tree_new(wmem_allocator_t *allocator)
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new(allocator);
+    tree->use_btree = TRUE;
+
+    return tree;
+}
+
 static gboolean
 wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
         void *user_data)
@@ -213,6 +224,7 @@ wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     wmem_tree_t *tree = (wmem_tree_t *)user_data;
 
     tree->root = NULL;
+    tree->btree = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
@@ -250,6 +262,17 @@ wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new_autoreset(metadata_scope, data_scope);
+    tree->use_btree = TRUE;
+
+    return tree;
+}
+
 static void
 free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, gboolean free_keys, gboolean free_values)
 {
@@ -280,10 +303,39 @@ free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, gboolean fre
     wmem_free(allocator, node);
 }
 
+static void
+free_btree_node(wmem_allocator_t *allocator, wmem_btree_node_t *node, gboolean free_keys, gboolean free_values)
+{
+    guint32 i;
+
+    if (node == NULL) {
+        return;
+    }
+
+    if (node->is_leaf) {
+        for (i = 0; i < node->count; i++) {
+            /* The keys are integers, so there is nothing to free for them */
+            if (node->u.leaf.is_subtree[i]) {
+                wmem_tree_destroy((wmem_tree_t *)node->u.leaf.data[i], free_keys, free_values);
+            }
+            else if (free_values) {
+                wmem_free(allocator, node->u.leaf.data[i]);
+            }
+        }
+    }
+    else {
+        for (i = 0; i <= node->count; i++) {
+            free_btree_node(allocator, node->u.children[i], free_keys, free_values);
+        }
+    }
+    wmem_free(allocator, node);
+}
+
 void
 wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 {
     free_tree_node(tree->data_allocator, tree->root, free_keys, free_values);
+    free_btree_node(tree->data_allocator, tree->btree, free_keys, free_values);
     if (tree->metadata_allocator) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
     }
@@ -296,7 +348,7 @@ wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 gboolean
 wmem_tree_is_empty(wmem_tree_t *tree)
 {
-    return tree->root == NULL;
+    return tree->root == NULL && tree->btree == NULL;
 }
 
 static gboolean
@@ -407,11 +459,296 @@ lookup_or_insert32_node(wmem_tree_t *tree, guint32 key,
 }
 
 
+/*
+ * B+tree for the guint32 keys of trees created by wmem_tree_new_btree().
+ *
+ * Entries are never deleted (wmem_tree_remove32() only sets their value to
+ * NULL, as for the red/black tree), so the separator keys[i] of an interior
+ * node is always the smallest key under children[i + 1]. That means that
+ * the leaf found by following the separators holds the largest key less
+ * than or equal to the search key, unless there is no such key at all.
+ */
+
+/* Enough for 2^32 keys in half-full nodes. */
+#define WMEM_BTREE_MAX_DEPTH 32
+
+/* Index of the first key greater than or equal to key. */
+static inline guint32
+btree_lower_bound(const guint32 *keys, guint32 count, guint32 key)
+{
+    guint32 lo = 0, hi = count;
+
+    while (lo < hi) {
+        guint32 mid = (lo + hi) / 2;
+        if (keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Index of the first key greater than key. */
+static inline guint32
+btree_upper_bound(const guint32 *keys, guint32 count, guint32 key)
+{
+    guint32 lo = 0, hi = count;
+
+    while (lo < hi) {
+        guint32 mid = (lo + hi) / 2;
+        if (keys[mid] <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static wmem_btree_node_t *
+btree_new_node(wmem_tree_t *tree, gboolean is_leaf)
+{
+    wmem_btree_node_t *node;
+
+    node = wmem_new(tree->data_allocator, wmem_btree_node_t);
+    node->count   = 0;
+    node->is_leaf = is_leaf;
+    if (is_leaf) {
+        node->u.leaf.next = NULL;
+    }
+
+    return node;
+}
+
+static wmem_btree_node_t *
+btree_find_leaf(const wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_node_t *node = tree->btree;
+
+    while (node && !node->is_leaf) {
+        node = node->u.children[btree_upper_bound(node->keys, node->count, key)];
+    }
+    return node;
+}
+
+static void
+btree_leaf_insert_at(wmem_btree_node_t *leaf, guint32 pos, guint32 key,
+        void *data, gboolean is_subtree)
+{
+    guint32 n = leaf->count - pos;
+
+    memmove(&leaf->keys[pos + 1], &leaf->keys[pos], n * sizeof leaf->keys[0]);
+    memmove(&leaf->u.leaf.data[pos + 1], &leaf->u.leaf.data[pos], n * sizeof leaf->u.leaf.data[0]);
+    memmove(&leaf->u.leaf.is_subtree[pos + 1], &leaf->u.leaf.is_subtree[pos], n);
+    leaf->keys[pos]              = key;
+    leaf->u.leaf.data[pos]       = data;
+    leaf->u.leaf.is_subtree[pos] = is_subtree ? 1 : 0;
+    leaf->count++;
+}
+
+static void *
+btree_lookup_or_insert32(wmem_tree_t *tree, guint32 key,
+        void*(*func)(void*), void* data, gboolean is_subtree, gboolean replace)
+{
+    wmem_btree_node_t *path[WMEM_BTREE_MAX_DEPTH];
+    guint32            path_pos[WMEM_BTREE_MAX_DEPTH];
+    guint32            depth = 0;
+    wmem_btree_node_t *node, *right;
+    guint32            pos, split, sep;
+    void              *value;
+
+    if (!tree->btree) {
+        tree->btree = btree_new_node(tree, TRUE);
+    }
+
+    node = tree->btree;
+    while (!node->is_leaf) {
+        pos = btree_upper_bound(node->keys, node->count, key);
+        path[depth]     = node;
+        path_pos[depth] = pos;
+        depth++;
+        node = node->u.children[pos];
+    }
+
+    pos = btree_lower_bound(node->keys, node->count, key);
+    if (pos < node->count && node->keys[pos] == key) {
+        /* this key already exists, so just return the data pointer */
+        if (replace) {
+            node->u.leaf.data[pos] = CREATE_DATA(func, data);
+        }
+        return node->u.leaf.data[pos];
+    }
+
+    value = CREATE_DATA(func, data);
+
+    if (node->count < WMEM_BTREE_MAX_KEYS) {
+        btree_leaf_insert_at(node, pos, key, value, is_subtree);
+        return value;
+    }
+
+    /* The leaf is full, so split it. Keys are very often inserted in
+     * increasing order (frame numbers, offsets), so when appending to the
+     * last leaf start a new one and leave the old one full rather than
+     * half empty. */
+    if (pos == WMEM_BTREE_MAX_KEYS && node->u.leaf.next == NULL) {
+        split = WMEM_BTREE_MAX_KEYS;
+    } else {
+        split = WMEM_BTREE_MAX_KEYS / 2;
+    }
+    right = btree_new_node(tree, TRUE);
+    right->count = WMEM_BTREE_MAX_KEYS - split;
+    memcpy(right->keys, &node->keys[split], right->count * sizeof node->keys[0]);
+    memcpy(right->u.leaf.data, &node->u.leaf.data[split], right->count * sizeof node->u.leaf.data[0]);
+    memcpy(right->u.leaf.is_subtree, &node->u.leaf.is_subtree[split], right->count);
+    node->count = split;
+    right->u.leaf.next = node->u.leaf.next;
+    node->u.leaf.next  = right;
+
+    if (pos < split) {
+        btree_leaf_insert_at(node, pos, key, value, is_subtree);
+    } else {
+        btree_leaf_insert_at(right, pos - split, key, value, is_subtree);
+    }
+    sep = right->keys[0];
+
+    /* Insert the new node into its parent, splitting that as well if it is
+     * full, and so on up to the root. */
+    while (depth > 0) {
+        guint32            keys[WMEM_BTREE_MAX_KEYS + 1];
+        wmem_btree_node_t *children[WMEM_BTREE_MAX_KEYS + 2];
+        wmem_btree_node_t *parent;
+        guint32            mid;
+
+        depth--;
+        parent = path[depth];
+        pos    = path_pos[depth];
+
+        if (parent->count < WMEM_BTREE_MAX_KEYS) {
+            memmove(&parent->keys[pos + 1], &parent->keys[pos],
+                    (parent->count - pos) * sizeof parent->keys[0]);
+            memmove(&parent->u.children[pos + 2], &parent->u.children[pos + 1],
+                    (parent->count - pos) * sizeof parent->u.children[0]);
+            parent->keys[pos]            = sep;
+            parent->u.children[pos + 1]  = right;
+            parent->count++;
+            return value;
+        }
+
+        memcpy(keys, parent->keys, pos * sizeof keys[0]);
+        keys[pos] = sep;
+        memcpy(&keys[pos + 1], &parent->keys[pos],
+                (WMEM_BTREE_MAX_KEYS - pos) * sizeof keys[0]);
+        memcpy(children, parent->u.children, (pos + 1) * sizeof children[0]);
+        children[pos + 1] = right;
+        memcpy(&children[pos + 2], &parent->u.children[pos + 1],
+                (WMEM_BTREE_MAX_KEYS - pos) * sizeof children[0]);
+
+        /* As for the leaves, keep the node full when appending to it. */
+        mid = (pos == WMEM_BTREE_MAX_KEYS) ? WMEM_BTREE_MAX_KEYS : WMEM_BTREE_MAX_KEYS / 2;
+
+        right = btree_new_node(tree, FALSE);
+        right->count = WMEM_BTREE_MAX_KEYS - mid;
+        memcpy(right->keys, &keys[mid + 1], right->count * sizeof keys[0]);
+        memcpy(right->u.children, &children[mid + 1], (right->count + 1) * sizeof children[0]);
+        parent->count = mid;
+        memcpy(parent->keys, keys, mid * sizeof keys[0]);
+        memcpy(parent->u.children, children, (mid + 1) * sizeof children[0]);
+        sep = keys[mid];
+    }
+
+    /* The root was split, so the tree gets a new root */
+    node = btree_new_node(tree, FALSE);
+    node->count         = 1;
+    node->keys[0]       = sep;
+    node->u.children[0] = tree->btree;
+    node->u.children[1] = right;
+    tree->btree = node;
+
+    return value;
+}
+
+static void *
+btree_lookup32(const wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    guint32 pos;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    pos = btree_lower_bound(leaf->keys, leaf->count, key);
+    if (pos < leaf->count && leaf->keys[pos] == key) {
+        return leaf->u.leaf.data[pos];
+    }
+    return NULL;
+}
+
+static void *
+btree_lookup32_le(const wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    guint32 pos;
+
+    if (!leaf) {
+        return NULL;
+    }
+
+    /* See above for why the previous leaf never needs to be checked */
+    pos = btree_upper_bound(leaf->keys, leaf->count, key);
+    if (pos == 0) {
+        return NULL;
+    }
+    return leaf->u.leaf.data[pos - 1];
+}
+
+static gboolean
+btree_foreach(const wmem_tree_t *tree, wmem_foreach_func callback, void *user_data)
+{
+    wmem_btree_node_t *leaf = tree->btree;
+    guint32 i;
+
+    if (!leaf) {
+        return FALSE;
+    }
+
+    while (!leaf->is_leaf) {
+        leaf = leaf->u.children[0];
+    }
+
+    /* Walk the linked leaves in key order */
+    for (; leaf; leaf = leaf->u.leaf.next) {
+        for (i = 0; i < leaf->count; i++) {
+            gboolean stop_traverse;
+
+            if (leaf->u.leaf.is_subtree[i]) {
+                stop_traverse = wmem_tree_foreach((wmem_tree_t *)leaf->u.leaf.data[i],
+                        callback, user_data);
+            } else {
+                stop_traverse = callback(GUINT_TO_POINTER(leaf->keys[i]),
+                        leaf->u.leaf.data[i], user_data);
+            }
+            if (stop_traverse) {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
 static void *
 lookup_or_insert32(wmem_tree_t *tree, guint32 key,
         void*(*func)(void*), void* data, gboolean is_subtree, gboolean replace)
 {
-    wmem_tree_node_t *node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
+    wmem_tree_node_t *node;
+
+    if (tree->use_btree) {
+        return btree_lookup_or_insert32(tree, key, func, data, is_subtree, replace);
+    }
+
+    node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
     return node->data;
 }
 
@@ -505,6 +842,10 @@ wmem_tree_lookup32(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->use_btree) {
+        return btree_lookup32(tree, key);
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -525,6 +866,10 @@ wmem_tree_lookup32_le(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->use_btree) {
+        return btree_lookup32_le(tree, key);
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -638,7 +983,12 @@ wmem_tree_remove_string(wmem_tree_t* tree, const gchar* k, guint32 flags)
 static void *
 create_sub_tree(void* d)
 {
-    return wmem_tree_new(((wmem_tree_t *)d)->data_allocator);
+    wmem_tree_t *tree = (wmem_tree_t *)d;
+
+    if (tree->use_btree) {
+        return wmem_tree_new_btree(tree->data_allocator);
+    }
+    return wmem_tree_new(tree->data_allocator);
 }
 
 void
@@ -754,6 +1104,10 @@ gboolean
 wmem_tree_foreach(wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data)
 {
+    /* A B+tree's guint32 keys come before any keys in its red/black tree */
+    if (btree_foreach(tree, callback, user_data))
+        return TRUE;
+
     if(!tree->root)
         return FALSE;
 
@@ -805,6 +1159,46 @@ wmem_tree_print_nodes(const char *prefix, wmem_tree_node_t *node, guint32 level,
         wmem_print_subtree((wmem_tree_t *)node->data, level+1, key_printer, data_printer);
 }
 
+static void
+wmem_tree_print_btree_nodes(wmem_btree_node_t *node, guint32 level,
+    wmem_printer_func key_printer, wmem_printer_func data_printer)
+{
+    guint32 i;
+
+    wmem_print_indent(level);
+
+    if (!node->is_leaf) {
+        ws_debug_printf("BNODE:%p keys:%u\n", (void *)node, node->count);
+        for (i = 0; i <= node->count; i++) {
+            if (i > 0) {
+                wmem_print_indent(level);
+                ws_debug_printf("key:%u\n", node->keys[i - 1]);
+            }
+            wmem_tree_print_btree_nodes(node->u.children[i], level+1, key_printer, data_printer);
+        }
+        return;
+    }
+
+    ws_debug_printf("BLEAF:%p keys:%u next:%p\n", (void *)node, node->count,
+            (void *)node->u.leaf.next);
+    for (i = 0; i < node->count; i++) {
+        wmem_print_indent(level);
+        ws_debug_printf("key:%u %s:%p\n", node->keys[i],
+                node->u.leaf.is_subtree[i]?"tree":"data", node->u.leaf.data[i]);
+        if (key_printer) {
+            wmem_print_indent(level);
+            key_printer(GUINT_TO_POINTER(node->keys[i]));
+            ws_debug_printf("\n");
+        }
+        if (node->u.leaf.is_subtree[i]) {
+            wmem_print_subtree((wmem_tree_t *)node->u.leaf.data[i], level+1, key_printer, data_printer);
+        } else if (data_printer) {
+            wmem_print_indent(level);
+            data_printer(node->u.leaf.data[i]);
+            ws_debug_printf("\n");
+        }
+    }
+}
 
 static void
 wmem_print_subtree(wmem_tree_t *tree, guint32 level, wmem_printer_func key_printer, wmem_printer_func data_printer)
@@ -815,6 +1209,9 @@ wmem_print_subtree(wmem_tree_t *tree, guint32 level, wmem_printer_func key_print
     wmem_print_indent(level);
 
     ws_debug_printf("WMEM tree:%p root:%p\n", (void *)tree, (void *)tree->root);
+    if (tree->btree) {
+        wmem_tree_print_btree_nodes(tree->btree, level, key_printer, data_printer);
+    }
     if (tree->root) {
         wmem_tree_print_nodes("Root-", tree->root, level, key_printer, data_printer);
     }
@@ -60,6 +60,30 @@ wmem_tree_t *
 wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
 G_GNUC_MALLOC;
 
+/** Creates a tree like wmem_tree_new(), but one that keeps its guint32 keys
+ * (including those of wmem_tree_insert32_array()) in a B+tree instead of a
+ * red/black tree. Each node holds up to 32 keys and the leaves are linked in
+ * key order, so lookups touch far fewer cache lines, wmem_tree_foreach() is a
+ * linear walk, and there is no allocation per insert. Trees filled in
+ * increasing key order, such as those keyed by frame number, use about a
+ * quarter of the memory. Since even a tree with a single key has a whole
+ * node, it is meant for trees with many keys rather than, for example, one
+ * per conversation. It is used with exactly the same functions as any other
+ * tree. String keys are still kept in a red/black tree.
+ */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator)
+G_GNUC_MALLOC;
+
+/** Creates a B+tree (see wmem_tree_new_btree()) that is emptied every time
+ * free_all occurs in the data scope (see wmem_tree_new_autoreset()).
+ */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
+G_GNUC_MALLOC;
+
 /** Cleanup memory used by tree.  Intended for NULL scope allocated trees */
 WS_DLL_PUBLIC
 void
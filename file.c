@@ -72,7 +72,8 @@
 #endif
 
 static gboolean read_record(capture_file *cf, wtap_rec *rec, Buffer *buf,
-    dfilter_t *dfcode, epan_dissect_t *edt, column_info *cinfo, gint64 offset);
+    dfilter_t *dfcode, epan_dissect_t *edt, epan_dissect_t *rf_edt,
+    column_info *cinfo, gint64 offset);
 
 static void rescan_packets(capture_file *cf, const char *action, const char *action_item, gboolean redissect);
 
@@ -506,6 +507,7 @@ cf_read(capture_file *cf, gboolean reloading)
   gint64               size;
   gint64               start_time;
   epan_dissect_t       edt;
+  epan_dissect_t       rf_edt;
   wtap_rec             rec;
   Buffer               buf;
   dfilter_t           *dfcode;
@@ -574,6 +576,8 @@ cf_read(capture_file *cf, gboolean reloading)
   start_time = g_get_monotonic_time();
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  if (cf->rfcode)
+    epan_dissect_init(&rf_edt, cf->epan, TRUE, FALSE);
 
   /* If any tap listeners require the columns, construct them. */
   cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cf->cinfo : NULL;
@@ -655,7 +659,7 @@ cf_read(capture_file *cf, gboolean reloading)
            hours even on fast machines) just to see that it was the wrong file. */
         break;
       }
-      read_record(cf, &rec, &buf, dfcode, &edt, cinfo, data_offset);
+      read_record(cf, &rec, &buf, dfcode, &edt, &rf_edt, cinfo, data_offset);
     }
   }
   CATCH(OutOfMemoryError) {
@@ -687,6 +691,8 @@ cf_read(capture_file *cf, gboolean reloading)
   dfilter_free(dfcode);
 
   epan_dissect_cleanup(&edt);
+  if (cf->rfcode)
+    epan_dissect_cleanup(&rf_edt);
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
@@ -783,6 +789,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
   volatile int      newly_displayed_packets = 0;
   dfilter_t        *dfcode;
   epan_dissect_t    edt;
+  epan_dissect_t    rf_edt;
   gboolean          create_proto_tree;
   guint             tap_flags;
   gboolean          compiled;
@@ -822,6 +829,8 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
   /*g_log(NULL, G_LOG_LEVEL_MESSAGE, "cf_continue_tail: %u new: %u", cf->count, to_read);*/
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  if (cf->rfcode)
+    epan_dissect_init(&rf_edt, cf->epan, TRUE, FALSE);
 
   TRY {
     gint64 data_offset = 0;
@@ -842,7 +851,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
            aren't any packets left to read) exit. */
         break;
       }
-      if (read_record(cf, rec, buf, dfcode, &edt, cinfo, data_offset)) {
+      if (read_record(cf, rec, buf, dfcode, &edt, &rf_edt, cinfo, data_offset)) {
         newly_displayed_packets++;
       }
       to_read--;
@@ -871,6 +880,8 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
   dfilter_free(dfcode);
 
   epan_dissect_cleanup(&edt);
+  if (cf->rfcode)
+    epan_dissect_cleanup(&rf_edt);
 
   /*g_log(NULL, G_LOG_LEVEL_MESSAGE, "cf_continue_tail: count %u state: %u err: %u",
     cf->count, cf->state, *err);*/
@@ -924,6 +935,7 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
   dfilter_t *dfcode;
   column_info *cinfo;
   epan_dissect_t edt;
+  epan_dissect_t rf_edt;
   gboolean   create_proto_tree;
   guint      tap_flags;
   gboolean   compiled;
@@ -967,6 +979,8 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
   /*packet_list_freeze();*/
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  if (cf->rfcode)
+    epan_dissect_init(&rf_edt, cf->epan, TRUE, FALSE);
 
   while ((wtap_read(cf->provider.wth, rec, buf, err, &err_info, &data_offset))) {
     if (cf->state == FILE_READ_ABORTED) {
@@ -975,13 +989,15 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
          aren't any packets left to read) exit. */
       break;
     }
-    read_record(cf, rec, buf, dfcode, &edt, cinfo, data_offset);
+    read_record(cf, rec, buf, dfcode, &edt, &rf_edt, cinfo, data_offset);
   }
 
   /* Cleanup and release all dfilter resources */
   dfilter_free(dfcode);
 
   epan_dissect_cleanup(&edt);
+  if (cf->rfcode)
+    epan_dissect_cleanup(&rf_edt);
 
   /* Don't freeze/thaw the list when doing live capture */
   /*packet_list_thaw();*/
@@ -1250,10 +1266,14 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
  * Read in a new record.
  * Returns TRUE if the packet was added to the packet (record) list,
  * FALSE otherwise.
+ *
+ * If there's a read filter, rf_edt is used to run it; it is set up
+ * once by the caller rather than for every record.
  */
 static gboolean
 read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
-            epan_dissect_t *edt, column_info *cinfo, gint64 offset)
+            epan_dissect_t *edt, epan_dissect_t *rf_edt, column_info *cinfo,
+            gint64 offset)
 {
   frame_data    fdlocal;
   frame_data   *fdata;
@@ -1275,15 +1295,12 @@ read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
   frame_data_init(&fdlocal, cf->count + 1, rec, offset, cf->cum_bytes);
 
   if (cf->rfcode) {
-    epan_dissect_t rf_edt;
-
-    epan_dissect_init(&rf_edt, cf->epan, TRUE, FALSE);
-    epan_dissect_prime_with_dfilter(&rf_edt, cf->rfcode);
-    epan_dissect_run(&rf_edt, cf->cd_t, rec,
+    epan_dissect_prime_with_dfilter(rf_edt, cf->rfcode);
+    epan_dissect_run(rf_edt, cf->cd_t, rec,
                      frame_tvbuff_new_buffer(&cf->provider, &fdlocal, buf),
                      &fdlocal, NULL);
-    passed = dfilter_apply_edt(cf->rfcode, &rf_edt);
-    epan_dissect_cleanup(&rf_edt);
+    passed = dfilter_apply_edt(cf->rfcode, rf_edt);
+    epan_dissect_reset(rf_edt);
   }
 
   if (passed) {
@@ -3273,6 +3290,31 @@ typedef struct {
  * significantly better.
  */
 
+/*
+ * Return the first byte at or after pd, and before end, that could start a
+ * match for text whose first character is c, or end if there is none. If
+ * case_insensitive is set, c is upper case and the data is compared as upper
+ * case. Most data can be skipped with memchr(), which is usually vectorized.
+ */
+static const guint8 *
+find_text_start(const guint8 *pd, const guint8 *end, guint8 c, gboolean case_insensitive)
+{
+  const guint8 *p;
+
+  if (pd >= end)
+    return end;
+
+  if (case_insensitive && g_ascii_isupper(c)) {
+    /* (b & 0xDF) == c only for b == c and its lower case version */
+    for (p = pd; p < end && (*p & 0xDF) != c; p++)
+      ;
+    return p;
+  }
+
+  p = (const guint8 *)memchr(pd, c, end - pd);
+  return p ? p : end;
+}
+
 gboolean
 cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
                     search_direction dir)
@@ -3332,6 +3374,12 @@ match_narrow_and_wide(capture_file *cf, frame_data *fdata,
   pd = ws_buffer_start_ptr(buf);
   i = 0;
   while (i < buf_len) {
+    if (c_match == 0) {
+      /* Skip to the next byte that could start a match. */
+      i = (guint32)(find_text_start(pd + i, pd + buf_len, ascii_text[0], cf->case_type) - pd);
+      if (i == buf_len)
+        break;
+    }
     c_char = pd[i];
     if (cf->case_type)
       c_char = g_ascii_toupper(c_char);
@@ -3364,12 +3412,11 @@ match_narrow(capture_file *cf, frame_data *fdata,
   cbs_t        *info       = (cbs_t *)criterion;
   const guint8 *ascii_text = info->data;
   size_t        textlen    = info->data_len;
-  match_result  result;
   guint32       buf_len;
-  guint8       *pd;
-  guint32       i;
-  guint8        c_char;
-  size_t        c_match    = 0;
+  const guint8 *pd;
+  const guint8 *last;
+  const guint8 *p;
+  size_t        c_match;
 
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -3377,33 +3424,35 @@ match_narrow(capture_file *cf, frame_data *fdata,
     return MR_ERROR;
   }
 
-  result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    c_char = pd[i];
-    if (cf->case_type)
-      c_char = g_ascii_toupper(c_char);
-    if (c_char == ascii_text[c_match]) {
-      c_match += 1;
-      if (c_match == textlen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)textlen;
-        break;
+  if (textlen == 0 || textlen > buf_len)
+    return MR_NOTMATCHED;
+
+  if (cf->case_type) {
+    /* The last place a match could start. */
+    last = pd + buf_len - textlen;
+    for (p = find_text_start(pd, last + 1, ascii_text[0], TRUE); p <= last;
+         p = find_text_start(p + 1, last + 1, ascii_text[0], TRUE)) {
+      for (c_match = 1; c_match < textlen; c_match++) {
+        if (g_ascii_toupper(p[c_match]) != ascii_text[c_match])
+          break;
       }
+      if (c_match == textlen)
+        break;
     }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
+    if (p > last)
+      return MR_NOTMATCHED;
+  } else {
+    p = epan_memmem(pd, buf_len, ascii_text, (guint)textlen);
+    if (p == NULL)
+      return MR_NOTMATCHED;
   }
 
-  return result;
+  /* Save the position of the last character for highlighting the field. */
+  cf->search_pos = (guint32)(p - pd + textlen - 1);
+  cf->search_len = (guint32)textlen;
+  return MR_MATCHED;
 }
 
 static match_result
@@ -3431,6 +3480,12 @@ match_wide(capture_file *cf, frame_data *fdata,
   pd = ws_buffer_start_ptr(buf);
   i = 0;
   while (i < buf_len) {
+    if (c_match == 0) {
+      /* Skip to the next byte that could start a match. */
+      i = (guint32)(find_text_start(pd + i, pd + buf_len, ascii_text[0], cf->case_type) - pd);
+      if (i == buf_len)
+        break;
+    }
     c_char = pd[i];
     if (cf->case_type)
       c_char = g_ascii_toupper(c_char);
@@ -3462,11 +3517,8 @@ match_binary(capture_file *cf, frame_data *fdata,
   cbs_t        *info        = (cbs_t *)criterion;
   const guint8 *binary_data = info->data;
   size_t        datalen     = info->data_len;
-  match_result  result;
-  guint32       buf_len;
-  guint8       *pd;
-  guint32       i;
-  size_t        c_match     = 0;
+  const guint8 *pd;
+  const guint8 *match;
 
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -3474,29 +3526,15 @@ match_binary(capture_file *cf, frame_data *fdata,
     return MR_ERROR;
   }
 
-  result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    if (pd[i] == binary_data[c_match]) {
-      c_match += 1;
-      if (c_match == datalen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)datalen;
-        break;
-      }
-    }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
-  }
-  return result;
+  match = epan_memmem(pd, fdata->cap_len, binary_data, (guint)datalen);
+  if (match == NULL)
+    return MR_NOTMATCHED;
+
+  /* Save the position of the last byte for highlighting the field. */
+  cf->search_pos = (guint32)(match - pd + datalen - 1);
+  cf->search_len = (guint32)datalen;
+  return MR_MATCHED;
 }
 
 static match_result
@@ -58,6 +58,10 @@
 #include <zlib.h>
 #endif
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 /* Ringbuffer file structure */
 typedef struct _rb_file {
   gchar         *name;
@@ -77,9 +81,11 @@ typedef struct _ringbuf_data {
   int           fd;                  /**< Current ringbuffer file descriptor */
   FILE         *pdh;
   char         *io_buffer;              /**< The IO buffer used to write to the file */
+  size_t        io_buffer_size;      /**< Requested size of io_buffer, or 0 for the default */
   gboolean      group_read_access;   /**< TRUE if files need to be opened with group read access */
   FILE         *name_h;              /**< write names of completed files to this handle */
   gchar        *compress_type;       /**< compress type */
+  GThreadPool  *compress_pool;       /**< threads compressing the finished files */
 
   GMutex        mutex;               /**< mutex for oldnames */
   gchar        *oldnames[MAX_FILENAME_QUEUE];       /**< filename list of pending to be deleted */
@@ -123,81 +129,210 @@ static void CleanupOldCap(gchar* name)
   g_mutex_unlock(&rb_data.mutex);
 }
 
+#define FS_READ_SIZE 65536
+
+#ifdef HAVE_ZLIB
 /*
- * compress capture file
+ * compress capture file with gzip
  */
-static int ringbuf_exec_compress(gchar* name)
+static gboolean ringbuf_compress_gzip(int fd, const gchar *name)
 {
-  guint8  *buffer = NULL;
-  gchar* outgz = NULL;
-  int  fd = -1;
-  ssize_t nread;
-  gboolean delete_org_file = TRUE;
-  gzFile fi = NULL;
-
-  fd = ws_open(name, O_RDONLY | O_BINARY, 0000);
-  if (fd < 0) {
-    return -1;
-  }
+  guint8  *buffer;
+  gchar   *outgz;
+  ssize_t  nread;
+  gboolean success = TRUE;
+  gzFile   fi;
 
   outgz = g_strdup_printf("%s.gz", name);
   fi = gzopen(outgz, "wb");
-  g_free(outgz);
   if (fi == NULL) {
-    ws_close(fd);
-    return -1;
+    g_free(outgz);
+    return FALSE;
   }
 
-#define FS_READ_SIZE 65536
   buffer = (guint8*)g_malloc(FS_READ_SIZE);
-  if (buffer == NULL) {
-    ws_close(fd);
-    gzclose(fi);
-    return -1;
-  }
-
   while ((nread = ws_read(fd, buffer, FS_READ_SIZE)) > 0) {
     int n = gzwrite(fi, buffer, (unsigned int)nread);
     if (n <= 0) {
       /* mark compression as failed */
-      delete_org_file = FALSE;
+      success = FALSE;
       break;
     }
   }
   if (nread < 0) {
     /* mark compression as failed */
-    delete_org_file = FALSE;
+    success = FALSE;
+  }
+  if (gzclose(fi) != Z_OK) {
+    success = FALSE;
   }
-  ws_close(fd);
-  gzclose(fi);
   g_free(buffer);
 
+  if (!success) {
+    ws_unlink(outgz);
+  }
+  g_free(outgz);
+  return success;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/* Same as the zstd command line tool */
+#define RINGBUF_ZSTD_LEVEL 3
+
+static gboolean ringbuf_write_all(int fd, const guint8 *buf, size_t count)
+{
+  while (count > 0) {
+    ssize_t nwritten = ws_write(fd, buf, (unsigned int)MIN(count, FS_READ_SIZE));
+    if (nwritten <= 0) {
+      return FALSE;
+    }
+    buf += nwritten;
+    count -= nwritten;
+  }
+  return TRUE;
+}
+
+/*
+ * compress capture file with Zstandard
+ */
+static gboolean ringbuf_compress_zstd(int fd, const gchar *name)
+{
+  ZSTD_CStream   *cstream;
+  ZSTD_inBuffer   input;
+  ZSTD_outBuffer  output;
+  guint8         *in_buffer;
+  guint8         *out_buffer;
+  size_t          out_size = ZSTD_CStreamOutSize();
+  size_t          ret;
+  gchar          *outzst;
+  int             out_fd;
+  ssize_t         nread = 0;
+  gboolean        success = TRUE;
+
+  outzst = g_strdup_printf("%s.zst", name);
+  out_fd = ws_open(outzst, O_WRONLY|O_BINARY|O_TRUNC|O_CREAT,
+                   rb_data.group_read_access ? 0640 : 0600);
+  if (out_fd < 0) {
+    g_free(outzst);
+    return FALSE;
+  }
+
+  cstream = ZSTD_createCStream();
+  if (cstream == NULL || ZSTD_isError(ZSTD_initCStream(cstream, RINGBUF_ZSTD_LEVEL))) {
+    success = FALSE;
+  }
+
+  in_buffer = (guint8*)g_malloc(FS_READ_SIZE);
+  out_buffer = (guint8*)g_malloc(out_size);
+  while (success && (nread = ws_read(fd, in_buffer, FS_READ_SIZE)) > 0) {
+    input.src = in_buffer;
+    input.size = nread;
+    input.pos = 0;
+    while (input.pos < input.size) {
+      output.dst = out_buffer;
+      output.size = out_size;
+      output.pos = 0;
+      ret = ZSTD_compressStream(cstream, &output, &input);
+      if (ZSTD_isError(ret) || !ringbuf_write_all(out_fd, out_buffer, output.pos)) {
+        success = FALSE;
+        break;
+      }
+    }
+  }
+  if (nread < 0) {
+    success = FALSE;
+  }
+  while (success) {
+    output.dst = out_buffer;
+    output.size = out_size;
+    output.pos = 0;
+    ret = ZSTD_endStream(cstream, &output);
+    if (ZSTD_isError(ret) || !ringbuf_write_all(out_fd, out_buffer, output.pos)) {
+      success = FALSE;
+    }
+    if (ret == 0) {
+      /* Everything has been flushed */
+      break;
+    }
+  }
+  if (ws_close(out_fd) != 0) {
+    success = FALSE;
+  }
+  ZSTD_freeCStream(cstream);
+  g_free(in_buffer);
+  g_free(out_buffer);
+
+  if (!success) {
+    ws_unlink(outzst);
+  }
+  g_free(outzst);
+  return success;
+}
+#endif
+
+/*
+ * compress capture file, in a thread of the compression pool
+ */
+static void ringbuf_compress_file(gpointer data, gpointer user_data)
+{
+  gchar       *name = (gchar*)data;
+  const gchar *compress_type = (const gchar*)user_data;
+  int          fd;
+  gboolean     success = FALSE;
+
+  if (compress_type == NULL) {
+    g_free(name);
+    return;
+  }
+
+  fd = ws_open(name, O_RDONLY | O_BINARY, 0000);
+  if (fd >= 0) {
+#ifdef HAVE_ZLIB
+    if (strcmp(compress_type, "gzip") == 0) {
+      success = ringbuf_compress_gzip(fd, name);
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (strcmp(compress_type, "zstd") == 0) {
+      success = ringbuf_compress_zstd(fd, name);
+    }
+#endif
+    ws_close(fd);
+  }
+
   /* delete the original file only if compression succeeds */
-  if (delete_org_file) {
+  if (success) {
     ws_unlink(name);
     CleanupOldCap(name);
   }
   g_free(name);
-  return 0;
 }
 
 /*
- * thread to compress capture file
+ * queue the capture file for compression
  */
-static void* exec_compress_thread(void* arg)
+static void ringbuf_start_compress_file(rb_file* rfile)
 {
-  ringbuf_exec_compress((gchar*)arg);
-  return NULL;
+  if (rb_data.compress_pool == NULL) {
+    /* Leave a processor for capturing. */
+    int max_threads = MAX((int)g_get_num_processors() - 1, 1);
+
+    rb_data.compress_pool = g_thread_pool_new(ringbuf_compress_file, rb_data.compress_type,
+                                              max_threads, FALSE, NULL);
+  }
+  g_thread_pool_push(rb_data.compress_pool, g_strdup(rfile->name), NULL);
 }
 
 /*
- * start a thread to compress capture file
+ * wait for the files queued for compression to be compressed
  */
-static int ringbuf_start_compress_file(rb_file* rfile)
+static void ringbuf_finish_compress(void)
 {
-  gchar* name = g_strdup(rfile->name);
-  g_thread_new("exec_compress", &exec_compress_thread, name);
-  return 0;
+  if (rb_data.compress_pool != NULL) {
+    g_thread_pool_free(rb_data.compress_pool, FALSE, TRUE);
+    rb_data.compress_pool = NULL;
+  }
 }
 
 /*
@@ -215,7 +350,7 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
       /* remove old file (if any, so ignore error) */
       ws_unlink(rfile->name);
     }
-    else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "gzip") == 0) {
+    else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "none") != 0) {
       ringbuf_start_compress_file(rfile);
     }
     g_free(rfile->name);
@@ -269,9 +404,11 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   rb_data.fd = -1;
   rb_data.pdh = NULL;
   rb_data.io_buffer = NULL;
+  rb_data.io_buffer_size = 0;
   rb_data.group_read_access = group_read_access;
   rb_data.name_h = NULL;
   rb_data.compress_type = compress_type;
+  rb_data.compress_pool = NULL;
   g_mutex_init(&rb_data.mutex);
 
   /* just to be sure ... */
@@ -398,12 +535,15 @@ ringbuf_init_libpcap_fdopen(int *err)
       *err = errno;
     }
   } else {
-    size_t buffsize = IO_BUF_SIZE;
+    size_t buffsize = rb_data.io_buffer_size ? rb_data.io_buffer_size : IO_BUF_SIZE;
 #ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
     ws_statb64 statb;
 
-    if (ws_fstat64(rb_data.fd, &statb) == 0) {
-      if (statb.st_blksize > IO_BUF_SIZE) {
+    if (ws_fstat64(rb_data.fd, &statb) == 0 && statb.st_blksize > 0) {
+      if (rb_data.io_buffer_size) {
+        /* Write whole file system blocks */
+        buffsize = (buffsize + statb.st_blksize - 1) / statb.st_blksize * statb.st_blksize;
+      } else if (statb.st_blksize > IO_BUF_SIZE) {
         buffsize = statb.st_blksize;
       }
     }
@@ -416,6 +556,16 @@ ringbuf_init_libpcap_fdopen(int *err)
   return rb_data.pdh;
 }
 
+/*
+ * Sets the size of the buffer used to write to the ringbuffer files, or
+ * 0 for the default. Larger buffers mean fewer, larger writes.
+ */
+void
+ringbuf_set_io_buffer_size(size_t size)
+{
+  rb_data.io_buffer_size = size;
+}
+
 /*
  * Switches to the next ringbuffer file
  */
@@ -493,6 +643,8 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 
   }
 
+  ringbuf_finish_compress();
+
   if (rb_data.name_h != NULL) {
     fprintf(rb_data.name_h, "%s\n", ringbuf_current_filename());
     fflush(rb_data.name_h);
@@ -559,6 +711,8 @@ ringbuf_error_cleanup(void)
     rb_data.fd = -1;
   }
 
+  ringbuf_finish_compress();
+
   if (rb_data.files != NULL) {
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
@@ -27,6 +27,7 @@ int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_
 gboolean ringbuf_is_initialized(void);
 const gchar *ringbuf_current_filename(void);
 FILE *ringbuf_init_libpcap_fdopen(int *err);
+void ringbuf_set_io_buffer_size(size_t size);
 gboolean ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd,
                              int *err);
 gboolean ringbuf_libpcap_dump_close(gchar **save_file, int *err);
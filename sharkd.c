@@ -512,6 +512,25 @@ sharkd_load_cap_file(void)
   return load_cap_file(&cfile, 0, 0);
 }
 
+/*
+ * Give this process its own descriptors for the loaded capture file.
+ * A session process forked after the file was loaded would otherwise
+ * share file positions with its parent and its siblings.
+ */
+int
+sharkd_reopen_cap_file(void)
+{
+  int err = 0;
+
+  if (cfile.provider.wth == NULL)
+    return 0;
+
+  wtap_fdclose(cfile.provider.wth);
+  if (!wtap_fdreopen(cfile.provider.wth, cfile.filename, &err))
+    return err;
+  return 0;
+}
+
 frame_data *
 sharkd_get_frame(guint32 framenum)
 {
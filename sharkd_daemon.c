@@ -37,6 +37,8 @@
 
 #include <wsutil/strtoi.h>
 #include <version_info.h>
+#include <wiretap/wtap.h>
+#include <epan/exceptions.h>
 
 #include "sharkd.h"
 
@@ -50,6 +52,7 @@
 
 static int mode = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+static const char *read_file = NULL;
 
 static socket_handle_t
 socket_init(char *path)
@@ -164,6 +167,7 @@ print_usage(FILE* output)
 	fprintf(output, "\n");
 	fprintf(output, "Classic (classic_options):\n");
 	fprintf(output, "  [-|<socket>]\n");
+	fprintf(output, "  (no other options; use the gold command line for -C or -r)\n");
 	fprintf(output, "\n");
 	fprintf(output, "  <socket> examples:\n");
 #ifdef SHARKD_UNIX_SUPPORT
@@ -181,11 +185,15 @@ print_usage(FILE* output)
 	fprintf(output, "  -v, --version            show version information\n");
 	fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
 	fprintf(output, "                           start with specified configuration profile\n");
+	fprintf(output, "  -r <infile>, --read-file <infile>\n");
+	fprintf(output, "                           load this capture file before accepting requests;\n");
+	fprintf(output, "                           sessions share it until they load another file\n");
 
 	fprintf(output, "\n");
 	fprintf(output, "  Examples:\n");
 	fprintf(output, "    sharkd -C myprofile\n");
 	fprintf(output, "    sharkd -a tcp:127.0.0.1:4446 -C myprofile\n");
+	fprintf(output, "    sharkd -a tcp:127.0.0.1:4446 -r capture.pcapng\n");
 
 	fprintf(output, "\n");
 	fprintf(output, "See the sharkd page of the Wireshark wiki for full details.\n");
@@ -215,7 +223,7 @@ sharkd_init(int argc, char **argv)
 	 * platform-dependent.
 	 */
 
-#define OPTSTRING "+" "a:hmvC:"
+#define OPTSTRING "+" "a:hmr:vC:"
 
 	static const char    optstring[] = OPTSTRING;
 
@@ -225,6 +233,7 @@ sharkd_init(int argc, char **argv)
 	  {"help", no_argument, NULL, 'h'},
 	  {"version", no_argument, NULL, 'v'},
 	  {"config-profile", required_argument, NULL, 'C'},
+	  {"read-file", required_argument, NULL, 'r'},
 	  {0, 0, 0, 0 }
 	};
 
@@ -246,6 +255,14 @@ sharkd_init(int argc, char **argv)
 	{
 		mode = SHARKD_MODE_CLASSIC_CONSOLE;
 
+		/* The classic command line takes no options; don't silently ignore them. */
+		if (argc > 2)
+		{
+			fprintf(stderr, "Options aren't supported with the classic command line: %s\n", argv[2]);
+			fprintf(stderr, "Use sharkd -h for details of supported options\n");
+			return -1;
+		}
+
 #ifndef _WIN32
 		signal(SIGCHLD, SIG_IGN);
 #endif
@@ -319,6 +336,10 @@ sharkd_init(int argc, char **argv)
 				mode = SHARKD_MODE_GOLD_CONSOLE;
 				break;
 
+			case 'r':        /* Read capture file */
+				read_file = optarg;
+				break;
+
 			case 'v':         /* Show version and exit */
 				show_version();
 				exit(0);
@@ -353,14 +374,50 @@ sharkd_init(int argc, char **argv)
 	return 0;
 }
 
+static int
+load_read_file(void)
+{
+	int err = 0;
+
+	if (sharkd_cf_open(read_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+		return -1;
+
+	TRY
+	{
+		err = sharkd_load_cap_file();
+	}
+	CATCH(OutOfMemoryError)
+	{
+		fprintf(stderr, "load: OutOfMemoryError\n");
+		err = ENOMEM;
+	}
+	ENDTRY;
+
+	return (err == 0) ? 0 : -1;
+}
+
 int
 sharkd_loop(int argc _U_, char* argv[])
 {
 	if (mode == SHARKD_MODE_CLASSIC_CONSOLE || mode == SHARKD_MODE_GOLD_CONSOLE)
 	{
+		if (read_file != NULL && load_read_file() < 0)
+			return -1;
 		return sharkd_session_main(mode);
 	}
 
+#ifndef _WIN32
+	/*
+	 * Load the capture file once, here, rather than in every session:
+	 * the session processes forked below start out with it already
+	 * loaded, sharing the frame data and dissection state with us
+	 * copy-on-write.  (On Windows, each session process gets -r and
+	 * loads the file itself.)
+	 */
+	if (read_file != NULL && load_read_file() < 0)
+		return -1;
+#endif
+
 	while (1)
 	{
 #ifndef _WIN32
@@ -391,6 +448,12 @@ sharkd_loop(int argc _U_, char* argv[])
 			dup2(fd, 1);
 			close(fd);
 
+			if (read_file != NULL && sharkd_reopen_cap_file() != 0)
+			{
+				fprintf(stderr, "cannot reopen %s\n", read_file);
+				exit(1);
+			}
+
 			exit(sharkd_session_main(mode));
 		}
 
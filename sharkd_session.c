@@ -80,6 +80,50 @@ struct sharkd_filter_item
 
 static GHashTable *filter_table = NULL;
 
+struct sharkd_column_cache_item
+{
+	guint32 frame_ref_num;
+	guint32 prev_dis_num;
+	gchar **col_data;
+};
+
+/*
+ * Column strings from earlier frames requests, keyed by frame number,
+ * so that scrolling back and forth through a capture doesn't dissect
+ * the same frames over and over.  They're only for the columns described
+ * by column_cache_key; a request for other columns empties the cache.
+ */
+#define SHARKD_COLUMN_CACHE_MAX_FRAMES 65536
+
+static GHashTable *column_cache = NULL;
+static gchar *column_cache_key = NULL;
+
+#define SHARKD_IOGRAPH_MAX_ITEMS 250000 /* 250k limit of items is taken from wireshark-qt, on x86_64 sizeof(io_graph_item_t) is 152, so single graph can take max 36 MB */
+#define SHARKD_IOGRAPH_BASE_ITEMS 50000 /* items are collected at intervals finer than requested only while they fit in this many items */
+
+struct sharkd_iograph
+{
+	/* config */
+	char *graph;
+	char *filter;
+	int hf_index;
+	io_graph_item_unit_t calc_type;
+	guint32 interval;
+
+	/* result */
+	int space_items;
+	int num_items;
+	io_graph_item_t *items;
+	GString *error;
+};
+
+/*
+ * Graphs from the last iograph request.  They're collected at a base
+ * interval that can be finer than the one requested, so that asking for
+ * the same graph at a multiple of it (e.g. when zooming) doesn't retap.
+ */
+static GSList *iograph_cache = NULL;
+
 static int mode;
 gboolean extended_log = FALSE;
 
@@ -192,6 +236,55 @@ sharkd_session_filter_free(gpointer data)
 	g_free(l);
 }
 
+static void
+sharkd_session_column_cache_item_free(gpointer data)
+{
+	struct sharkd_column_cache_item *item = (struct sharkd_column_cache_item *) data;
+
+	g_strfreev(item->col_data);
+	g_free(item);
+}
+
+/*
+ * Forget all cached column strings; call this whenever something
+ * that affects the columns (the capture file, preferences, comments)
+ * changes.
+ */
+static void
+sharkd_session_column_cache_flush(void)
+{
+	if (column_cache)
+		g_hash_table_remove_all(column_cache);
+
+	g_free(column_cache_key);
+	column_cache_key = NULL;
+}
+
+static void
+sharkd_session_iograph_free(gpointer data)
+{
+	struct sharkd_iograph *graph = (struct sharkd_iograph *) data;
+
+	g_free(graph->graph);
+	g_free(graph->filter);
+	g_free(graph->items);
+	if (graph->error)
+		g_string_free(graph->error, TRUE);
+	g_free(graph);
+}
+
+/*
+ * Forget all cached iograph items; call this whenever something
+ * that affects dissection (the capture file, preferences, comments)
+ * changes.
+ */
+static void
+sharkd_session_iograph_cache_flush(void)
+{
+	g_slist_free_full(iograph_cache, sharkd_session_iograph_free);
+	iograph_cache = NULL;
+}
+
 static const struct sharkd_filter_item *
 sharkd_session_filter_data(const char *filter)
 {
@@ -549,6 +642,9 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 	fprintf(stderr, "load: filename=%s\n", tok_file);
 
+	sharkd_session_column_cache_flush();
+	sharkd_session_iograph_cache_flush();
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		sharkd_json_simple_reply(err, NULL);
@@ -764,11 +860,79 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
 	return cinfo;
 }
 
+/*
+ * Describe a set of columns, for checking whether the column cache is
+ * for the same columns; the default columns are "".
+ */
+static gchar *
+sharkd_session_columns_key(const column_info *cinfo)
+{
+	GString *key = g_string_new(NULL);
+	int col;
+
+	if (cinfo == &cfile.cinfo)
+		return g_string_free(key, FALSE);
+
+	for (col = 0; col < cinfo->num_cols; col++)
+	{
+		const col_item_t *col_item = &cinfo->columns[col];
+
+		if (col_item->col_fmt == COL_CUSTOM)
+			g_string_append_printf(key, "%s:%d,", col_item->col_custom_fields, col_item->col_custom_occurrence);
+		else
+			g_string_append_printf(key, "%d,", col_item->col_fmt);
+	}
+
+	return g_string_free(key, FALSE);
+}
+
+/*
+ * Get the column strings for a frame, from the column cache if they're
+ * there for the same reference and previous displayed frames, otherwise
+ * by dissecting it.
+ */
+static gchar **
+sharkd_session_frame_columns(frame_data *fdata, guint32 ref_frame, guint32 prev_dis_num, column_info *cinfo)
+{
+	struct sharkd_column_cache_item *item;
+	int col;
+
+	item = (struct sharkd_column_cache_item *) g_hash_table_lookup(column_cache, GUINT_TO_POINTER(fdata->num));
+	if (item && item->frame_ref_num == ref_frame && item->prev_dis_num == prev_dis_num)
+		return item->col_data;
+
+	sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
+
+	if (!item)
+	{
+		if (g_hash_table_size(column_cache) >= SHARKD_COLUMN_CACHE_MAX_FRAMES)
+			g_hash_table_remove_all(column_cache);
+
+		item = g_new0(struct sharkd_column_cache_item, 1);
+		g_hash_table_insert(column_cache, GUINT_TO_POINTER(fdata->num), item);
+	}
+	else
+		g_strfreev(item->col_data);
+
+	item->frame_ref_num = ref_frame;
+	item->prev_dis_num = prev_dis_num;
+	item->col_data = g_new(gchar *, cinfo->num_cols + 1);
+	for (col = 0; col < cinfo->num_cols; ++col)
+		item->col_data[col] = g_strdup(cinfo->columns[col].col_data);
+	item->col_data[cinfo->num_cols] = NULL;
+
+	return item->col_data;
+}
+
 /**
  * sharkd_session_process_frames()
  *
  * Process frames request
  *
+ * Column strings are cached between requests, so paging through the
+ * capture with skip and limit only dissects frames that haven't been
+ * returned before.
+ *
  * Input:
  *   (o) column0...columnXX - requested columns either number in range [0..NUM_COL_FMTS), or custom (syntax <dfilter>:<occurence>).
  *                            If column0 is not specified default column set will be used.
@@ -806,6 +970,7 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
 	column_info *cinfo = &cfile.cinfo;
 	column_info user_cinfo;
+	gchar *columns_key;
 
 	if (tok_column)
 	{
@@ -845,10 +1010,20 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 			return;
 	}
 
+	columns_key = sharkd_session_columns_key(cinfo);
+	if (g_strcmp0(columns_key, column_cache_key) != 0)
+	{
+		sharkd_session_column_cache_flush();
+		column_cache_key = columns_key;
+	}
+	else
+		g_free(columns_key);
+
 	sharkd_json_array_open(NULL);
 	for (framenum = 1; framenum <= cfile.count; framenum++)
 	{
 		frame_data *fdata;
+		gchar **col_data;
 		guint32 ref_frame = (framenum != 1) ? 1 : 0;
 
 		if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
@@ -893,17 +1068,13 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 		}
 
 		fdata = sharkd_get_frame(framenum);
-		sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
+		col_data = sharkd_session_frame_columns(fdata, ref_frame, prev_dis_num, cinfo);
 
 		json_dumper_begin_object(&dumper);
 
 		sharkd_json_array_open("c");
 		for (col = 0; col < cinfo->num_cols; ++col)
-		{
-			const col_item_t *col_item = &cinfo->columns[col];
-
-			sharkd_json_value_string(NULL, col_item->col_data);
-		}
+			sharkd_json_value_string(NULL, col_data[col]);
 		sharkd_json_array_close();
 
 		sharkd_json_value_anyf("num", "%u", framenum);
@@ -2920,22 +3091,6 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
 	json_dumper_finish(&dumper);
 }
 
-#define SHARKD_IOGRAPH_MAX_ITEMS 250000 /* 250k limit of items is taken from wireshark-qt, on x86_64 sizeof(io_graph_item_t) is 152, so single graph can take max 36 MB */
-
-struct sharkd_iograph
-{
-	/* config */
-	int hf_index;
-	io_graph_item_unit_t calc_type;
-	guint32 interval;
-
-	/* result */
-	int space_items;
-	int num_items;
-	io_graph_item_t *items;
-	GString *error;
-};
-
 static tap_packet_status
 sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_)
 {
@@ -2992,12 +3147,36 @@ sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const vo
  *                  errmsg - graph cannot be constructed
  *                  items  - graph values, zeros are skipped, if value is not a number it's next index encoded as hex string
  */
+/*
+ * Take the graph for tok_graph and tok_filter out of the cache, if it was
+ * collected at an interval that divides interval_ms.
+ */
+static struct sharkd_iograph *
+sharkd_session_iograph_cache_take(const char *tok_graph, const char *tok_filter, guint32 interval_ms)
+{
+	GSList *l;
+
+	for (l = iograph_cache; l; l = l->next)
+	{
+		struct sharkd_iograph *graph = (struct sharkd_iograph *) l->data;
+
+		if (!strcmp(graph->graph, tok_graph) && !g_strcmp0(graph->filter, tok_filter) && interval_ms % graph->interval == 0)
+		{
+			iograph_cache = g_slist_delete_link(iograph_cache, l);
+			return graph;
+		}
+	}
+
+	return NULL;
+}
+
 static void
 sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 {
 	const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
-	struct sharkd_iograph graphs[10];
-	gboolean is_any_ok = FALSE;
+	struct sharkd_iograph *graphs[10];
+	gboolean tapping[10];
+	gboolean is_any_tapping = FALSE;
 	int graph_count;
 
 	guint32 interval_ms = 1000; /* default: one per second */
@@ -3014,7 +3193,8 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 
 	for (i = graph_count = 0; i < (int) G_N_ELEMENTS(graphs); i++)
 	{
-		struct sharkd_iograph *graph = &graphs[graph_count];
+		struct sharkd_iograph *graph;
+		io_graph_item_unit_t calc_type;
 
 		const char *tok_graph;
 		const char *tok_filter;
@@ -3030,79 +3210,108 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 		tok_filter = json_find_attr(buf, tokens, count, tok_format_buf);
 
 		if (!strcmp(tok_graph, "packets"))
-			graph->calc_type = IOG_ITEM_UNIT_PACKETS;
+			calc_type = IOG_ITEM_UNIT_PACKETS;
 		else if (!strcmp(tok_graph, "bytes"))
-			graph->calc_type = IOG_ITEM_UNIT_BYTES;
+			calc_type = IOG_ITEM_UNIT_BYTES;
 		else if (!strcmp(tok_graph, "bits"))
-			graph->calc_type = IOG_ITEM_UNIT_BITS;
+			calc_type = IOG_ITEM_UNIT_BITS;
 		else if (g_str_has_prefix(tok_graph, "sum:"))
-			graph->calc_type = IOG_ITEM_UNIT_CALC_SUM;
+			calc_type = IOG_ITEM_UNIT_CALC_SUM;
 		else if (g_str_has_prefix(tok_graph, "frames:"))
-			graph->calc_type = IOG_ITEM_UNIT_CALC_FRAMES;
+			calc_type = IOG_ITEM_UNIT_CALC_FRAMES;
 		else if (g_str_has_prefix(tok_graph, "fields:"))
-			graph->calc_type = IOG_ITEM_UNIT_CALC_FIELDS;
+			calc_type = IOG_ITEM_UNIT_CALC_FIELDS;
 		else if (g_str_has_prefix(tok_graph, "max:"))
-			graph->calc_type = IOG_ITEM_UNIT_CALC_MAX;
+			calc_type = IOG_ITEM_UNIT_CALC_MAX;
 		else if (g_str_has_prefix(tok_graph, "min:"))
-			graph->calc_type = IOG_ITEM_UNIT_CALC_MIN;
+			calc_type = IOG_ITEM_UNIT_CALC_MIN;
 		else if (g_str_has_prefix(tok_graph, "avg:"))
-			graph->calc_type = IOG_ITEM_UNIT_CALC_AVERAGE;
+			calc_type = IOG_ITEM_UNIT_CALC_AVERAGE;
 		else if (g_str_has_prefix(tok_graph, "load:"))
-			graph->calc_type = IOG_ITEM_UNIT_CALC_LOAD;
+			calc_type = IOG_ITEM_UNIT_CALC_LOAD;
 		else
 			break;
 
-		field_name = strchr(tok_graph, ':');
-		if (field_name)
-			field_name = field_name + 1;
+		tapping[graph_count] = FALSE;
+
+		graph = sharkd_session_iograph_cache_take(tok_graph, tok_filter, interval_ms);
+		if (!graph)
+		{
+			field_name = strchr(tok_graph, ':');
+			if (field_name)
+				field_name = field_name + 1;
 
-		graph->interval = interval_ms;
+			graph = g_new0(struct sharkd_iograph, 1);
+			graph->graph = g_strdup(tok_graph);
+			graph->filter = g_strdup(tok_filter);
+			graph->calc_type = calc_type;
+			graph->interval = get_io_graph_base_interval(interval_ms, calc_type, &cfile.elapsed_time, SHARKD_IOGRAPH_BASE_ITEMS);
 
-		graph->hf_index = -1;
-		graph->error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
+			graph->hf_index = -1;
+			graph->error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
 
-		graph->space_items = 0; /* TODO, can avoid realloc()s in sharkd_iograph_packet() by calculating: capture_time / interval */
-		graph->num_items = 0;
-		graph->items = NULL;
+			graph->space_items = 0; /* TODO, can avoid realloc()s in sharkd_iograph_packet() by calculating: capture_time / interval */
+			graph->num_items = 0;
+			graph->items = NULL;
 
-		if (!graph->error)
-			graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+			if (!graph->error)
+				graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
 
-		graph_count++;
+			if (graph->error == NULL)
+			{
+				tapping[graph_count] = TRUE;
+				is_any_tapping = TRUE;
+			}
+		}
 
-		if (graph->error == NULL)
-			is_any_ok = TRUE;
+		graphs[graph_count++] = graph;
 	}
 
-	/* retap only if we have at least one ok */
-	if (is_any_ok)
+	/* retap only if we have at least one ok graph which isn't cached */
+	if (is_any_tapping)
 		sharkd_retap();
 
+	/* the graphs from this request replace the cached ones */
+	sharkd_session_iograph_cache_flush();
+
 	json_dumper_begin_object(&dumper);
 
 	sharkd_json_array_open("iograph");
 	for (i = 0; i < graph_count; i++)
 	{
-		struct sharkd_iograph *graph = &graphs[i];
+		struct sharkd_iograph *graph = graphs[i];
+
+		if (tapping[i])
+			remove_tap_listener(graph);
 
 		json_dumper_begin_object(&dumper);
 
 		if (graph->error)
 		{
 			sharkd_json_value_string("errmsg", graph->error->str);
-			g_string_free(graph->error, TRUE);
 		}
 		else
 		{
+			const io_graph_item_t *items = graph->items;
+			io_graph_item_t *rollup_items = NULL;
+			int num_items = graph->num_items;
+			int factor = interval_ms / graph->interval;
 			int idx;
 			int next_idx = 0;
 
+			if (factor > 1 && num_items > 0)
+			{
+				rollup_items = g_new(io_graph_item_t, (num_items + factor - 1) / factor);
+				num_items = rollup_io_graph_items(rollup_items, graph->items, graph->num_items, factor, graph->hf_index, graph->calc_type);
+				items = rollup_items;
+			}
+
 			sharkd_json_array_open("items");
-			for (idx = 0; idx < graph->num_items; idx++)
+			for (idx = 0; idx < num_items; idx++)
 			{
 				double val;
 
-				val = get_io_graph_item(graph->items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, graph->num_items);
+				val = get_io_graph_item(items, graph->calc_type, idx, graph->hf_index, &cfile, interval_ms, num_items);
 
 				/* if it's zero, don't display */
 				if (val == 0.0)
@@ -3116,11 +3325,15 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 				next_idx = idx + 1;
 			}
 			sharkd_json_array_close();
+
+			g_free(rollup_items);
 		}
 		json_dumper_end_object(&dumper);
 
-		remove_tap_listener(graph);
-		g_free(graph->items);
+		if (graph->error)
+			sharkd_session_iograph_free(graph);
+		else
+			iograph_cache = g_slist_prepend(iograph_cache, graph);
 	}
 	sharkd_json_array_close();
 
@@ -3590,6 +3803,10 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
 
 	ret = sharkd_set_user_comment(fdata, tok_comment);
 
+	/* Comments can be shown in custom columns and matched by filters. */
+	sharkd_session_column_cache_flush();
+	sharkd_session_iograph_cache_flush();
+
 	sharkd_json_simple_reply(ret, NULL);
 }
 
@@ -3622,6 +3839,9 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 
 	ret = prefs_set_pref(pref, &errmsg);
 
+	sharkd_session_column_cache_flush();
+	sharkd_session_iograph_cache_flush();
+
 	sharkd_json_simple_reply(ret, errmsg);
 	g_free(errmsg);
 }
@@ -4267,6 +4487,7 @@ sharkd_session_main(int mode_setting)
 	dumper.output_file = stdout;
 
 	filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+	column_cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, sharkd_session_column_cache_item_free);
 
 #ifdef HAVE_MAXMINDDB
 	/* mmdbresolve was stopped before fork(), force starting it */
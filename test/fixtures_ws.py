@@ -8,6 +8,7 @@
 '''Fixtures that are specific to Wireshark.'''
 
 from contextlib import contextmanager
+import importlib.util
 import os
 import re
 import subprocess
@@ -182,6 +183,8 @@ def features(cmd_tshark, make_env):
         have_gnutls='with GnuTLS' in tshark_v,
         have_pkcs11='and PKCS #11 support' in tshark_v,
         have_brotli='with brotli' in tshark_v,
+        have_zlib='with zlib' in tshark_v,
+        have_zstd='with Zstandard' in tshark_v,
     )
 
 
@@ -200,6 +203,16 @@ def dirs():
     )
 
 
+@fixtures.fixture(scope='session')
+def pcapgen(dirs):
+    '''Returns the tools/pcapgen.py module, for writing synthetic captures.'''
+    spec = importlib.util.spec_from_file_location('pcapgen',
+        os.path.join(dirs.tools_dir, 'pcapgen.py'))
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
 @fixtures.fixture(scope='session')
 def capture_file(dirs):
     '''Returns the path to a capture file.'''
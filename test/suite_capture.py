@@ -301,6 +301,119 @@ def check_dumpcap_ringbuffer_stdin(cmd_dumpcap):
     return check_dumpcap_ringbuffer_stdin_real
 
 
+@fixtures.fixture
+def check_dumpcap_ringbuffer_compress_stdin(cmd_dumpcap, features):
+    def check_dumpcap_ringbuffer_compress_stdin_real(self, compress_type):
+        # Similar to check_dumpcap_ringbuffer_stdin.
+        if compress_type == 'gzip' and not features.have_zlib:
+            fixtures.skip('Requires zlib.')
+        if compress_type == 'zstd' and not features.have_zstd:
+            fixtures.skip('Requires Zstandard.')
+        suffix = {'gzip': 'gz', 'zstd': 'zst'}[compress_type]
+        rb_unique = 'dhcp_rb_' + uuid.uuid4().hex[:6] # Random ID
+        testout_file = '{}.{}.pcapng'.format(self.id(), rb_unique)
+        testout_glob = '{}.{}_*.pcapng'.format(self.id(), rb_unique)
+        compressed_glob = '{}.{}'.format(testout_glob, suffix)
+        cat100_dhcp_cmd = subprocesstest.cat_dhcp_command('cat100')
+
+        capture_cmd = ' '.join((cmd_dumpcap,
+            '-i', '-',
+            '-w', testout_file,
+            '-b', 'packets:47',
+            '--compress-type', compress_type,
+        ))
+        pipe_proc = self.assertRun(cat100_dhcp_cmd + ' | ' + capture_cmd, shell=True)
+
+        rb_files = glob.glob(testout_glob)
+        compressed_files = glob.glob(compressed_glob)
+        for rbf in rb_files + compressed_files:
+            self.cleanup_files.append(rbf)
+
+        # The two files that were switched away from have been compressed,
+        # and the originals removed. The last file is left alone.
+        self.assertEqual(len(compressed_files), 2)
+        self.assertEqual(len(rb_files), 1)
+        for rbf in compressed_files:
+            self.checkPacketCount(47, cap_file=rbf)
+        self.checkPacketCount(6, cap_file=rb_files[0])
+    return check_dumpcap_ringbuffer_compress_stdin_real
+
+
+@fixtures.fixture
+def check_dumpcap_threads(cmd_dumpcap):
+    def check_dumpcap_threads_real(self, multi_input=False, extra_args=()):
+        # Similar to check_capture_stdin, but with a capture thread per source.
+        testout_file = self.filename_from_id(testout_pcapng)
+        cat100_dhcp_cmd = subprocesstest.cat_dhcp_command('cat100')
+        if not multi_input:
+            capture_cmd = ' '.join((cmd_dumpcap,
+                '-t',
+                '-i', '-',
+                '-w', testout_file,
+            ) + tuple(extra_args))
+            self.assertRun(cat100_dhcp_cmd + ' | ' + capture_cmd, shell=True)
+            self.assertTrue(os.path.isfile(testout_file))
+            self.checkPacketCount(100, cap_file=testout_file)
+            return
+
+        if sys.platform == 'win32':
+            fixtures.skip('Test requires OS fifo support.')
+        fifo_files = []
+        fifo_procs = []
+        for fifo_num in (1, 2):
+            fifo_file = self.filename_from_id('dumpcap_threads_{}.fifo'.format(fifo_num))
+            # If a previous test left its fifo laying around, e.g. from a failure, remove it.
+            try:
+                os.unlink(fifo_file)
+            except Exception: pass
+            os.mkfifo(fifo_file)
+            fifo_files.append(fifo_file)
+            fifo_procs.append(self.startProcess(('{0} > {1}'.format(cat100_dhcp_cmd, fifo_file)), shell=True))
+        self.assertRun(capture_command(cmd_dumpcap,
+            '-t',
+            '-i', fifo_files[0],
+            '-i', fifo_files[1],
+            '-w', testout_file,
+            *extra_args
+        ))
+        for fifo_proc in fifo_procs: fifo_proc.kill()
+        self.assertTrue(os.path.isfile(testout_file))
+        self.checkPacketCount(200, cap_file=testout_file)
+    return check_dumpcap_threads_real
+
+
+@fixtures.fixture
+def check_dumpcap_io_buffer_size(cmd_dumpcap):
+    def check_dumpcap_io_buffer_size_real(self, ringbuffer=False):
+        # Similar to check_capture_stdin and check_dumpcap_ringbuffer_stdin.
+        rb_unique = 'dhcp_iobuf_' + uuid.uuid4().hex[:6] # Random ID
+        testout_file = '{}.{}.pcapng'.format(self.id(), rb_unique)
+        testout_glob = '{}.{}_*.pcapng'.format(self.id(), rb_unique)
+        cat100_dhcp_cmd = subprocesstest.cat_dhcp_command('cat100')
+        capture_args = (cmd_dumpcap,
+            '-i', '-',
+            '-w', testout_file,
+            '--io-buffer-size', '256',
+        )
+        if ringbuffer:
+            capture_args += ('-b', 'packets:47')
+        self.assertRun(cat100_dhcp_cmd + ' | ' + ' '.join(capture_args), shell=True)
+
+        if not ringbuffer:
+            self.cleanup_files.append(testout_file)
+            self.assertTrue(os.path.isfile(testout_file))
+            self.checkPacketCount(100, cap_file=testout_file)
+            return
+
+        rb_files = sorted(glob.glob(testout_glob))
+        for rbf in rb_files:
+            self.cleanup_files.append(rbf)
+        self.assertEqual(len(rb_files), 3)
+        for rbf, count in zip(rb_files, (47, 47, 6)):
+            self.checkPacketCount(count, cap_file=rbf)
+    return check_dumpcap_io_buffer_size_real
+
+
 @fixtures.fixture
 def check_dumpcap_pcapng_sections(cmd_dumpcap, cmd_tshark, capture_file):
     if sys.platform == 'win32':
@@ -569,6 +682,58 @@ class case_dumpcap_ringbuffer(subprocesstest.SubprocessTestCase):
         '''Capture from stdin using Dumpcap and write multiple files until we reach a packet limit'''
         check_dumpcap_ringbuffer_stdin(self, packets=47) # Last prime before 50. Arbitrary.
 
+    def test_dumpcap_ringbuffer_compress_gzip(self, check_dumpcap_ringbuffer_compress_stdin):
+        '''Capture from stdin using Dumpcap and gzip the files as they are finished'''
+        check_dumpcap_ringbuffer_compress_stdin(self, 'gzip')
+
+    def test_dumpcap_ringbuffer_compress_zstd(self, check_dumpcap_ringbuffer_compress_stdin):
+        '''Capture from stdin using Dumpcap and compress the files with Zstandard as they are finished'''
+        check_dumpcap_ringbuffer_compress_stdin(self, 'zstd')
+
+
+@fixtures.mark_usefixtures('base_env')
+@fixtures.uses_fixtures
+class case_dumpcap_io_buffer_size(subprocesstest.SubprocessTestCase):
+    def test_dumpcap_io_buffer_size_file(self, check_dumpcap_io_buffer_size):
+        '''Capture from stdin using Dumpcap and a larger write buffer'''
+        check_dumpcap_io_buffer_size(self)
+
+    def test_dumpcap_io_buffer_size_ringbuffer(self, check_dumpcap_io_buffer_size):
+        '''Capture from stdin using Dumpcap and a larger write buffer, writing multiple files'''
+        check_dumpcap_io_buffer_size(self, ringbuffer=True)
+
+
+@fixtures.mark_usefixtures('base_env')
+@fixtures.uses_fixtures
+class case_dumpcap_threads(subprocesstest.SubprocessTestCase):
+    def test_dumpcap_threads_single_in(self, check_dumpcap_threads):
+        '''Capture from stdin using Dumpcap with a capture thread'''
+        check_dumpcap_threads(self)
+
+    def test_dumpcap_threads_multi_in(self, check_dumpcap_threads):
+        '''Capture from two pipes using Dumpcap with a capture thread each'''
+        check_dumpcap_threads(self, multi_input=True)
+
+    def test_dumpcap_threads_huge_packet_limit(self, check_dumpcap_threads):
+        '''Capture with a capture thread and a packet limit far larger than the queue'''
+        # The queue must not be sized for the limit up front.
+        check_dumpcap_threads(self, extra_args=('-N', '2000000000'))
+
+    def test_dumpcap_threads_backpressure(self, cmd_dumpcap):
+        '''Capture with a capture thread and a queue that fills up at once'''
+        # A limit of one packet means the first packet queued fills it.
+        testout_file = self.filename_from_id(testout_pcapng)
+        cat100_dhcp_cmd = subprocesstest.cat_dhcp_command('cat100')
+        capture_cmd = ' '.join((cmd_dumpcap,
+            '-t',
+            '-N', '1',
+            '-i', '-',
+            '-w', testout_file,
+        ))
+        capture_proc = self.assertRun(cat100_dhcp_cmd + ' | ' + capture_cmd, shell=True)
+        self.assertTrue(os.path.isfile(testout_file))
+        self.assertIn('The queue of interface 0 is filling up', capture_proc.stderr_str)
+
 
 @fixtures.mark_usefixtures('base_env')
 @fixtures.uses_fixtures
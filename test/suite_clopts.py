@@ -31,6 +31,18 @@ class case_dumpcap_options(subprocesstest.SubprocessTestCase):
             self.assertRun((cmd_dumpcap, '-' + char_arg), env=base_env,
                            expected_return=self.exit_command_line)
 
+    def test_dumpcap_invalid_io_buffer_size(self, cmd_dumpcap, base_env):
+        '''Invalid dumpcap output buffer sizes'''
+        for size in ('0', '-1', 'big', str(1024 * 1024 + 1)):
+            self.assertRun((cmd_dumpcap, '--io-buffer-size', size), env=base_env,
+                           expected_return=self.exit_command_line)
+
+    def test_dumpcap_invalid_compress_type(self, cmd_dumpcap, base_env):
+        '''Invalid dumpcap file compression types'''
+        for compress_type in ('lz4', 'GZIP', ''):
+            self.assertRun((cmd_dumpcap, '--compress-type', compress_type), env=base_env,
+                           expected_return=self.exit_command_line)
+
     # XXX Should we generate individual test functions instead of looping?
     def test_dumpcap_valid_chars(self, cmd_dumpcap, base_env):
         for char_arg in 'hv':
@@ -282,6 +294,14 @@ class case_tshark_z_expert(subprocesstest.SubprocessTestCase):
         self.assertFalse(self.grepOutput('Warns'))
         self.assertFalse(self.grepOutput('Chats'))
 
+    def test_tshark_z_expert_shared_filter(self, cmd_tshark, capture_file):
+        # Listeners with the same filter share its result for each packet.
+        self.assertRun((cmd_tshark, '-q',
+            '-z', 'expert,error,tcp', '-z', 'expert,error,udp',
+            '-z', 'expert,error,tcp', '-z', 'expert,error,udp',
+            '-r', capture_file('http-ooo.pcap')))
+        self.assertEqual(self.countOutput('Errors'), 2)
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
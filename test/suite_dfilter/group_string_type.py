@@ -177,3 +177,19 @@ class case_string(unittest.TestCase):
     def test_contains_unicode(self, checkDFilterCount):
         dfilter = 'tcp.flags.str contains "·······AP···"'
         checkDFilterCount(dfilter, 1)
+
+    def test_matches_literal_1(self, checkDFilterCount):
+        dfilter = 'http.request.method matches "EAD"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_matches_literal_2(self, checkDFilterCount):
+        dfilter = 'http.request.method matches "POST"'
+        checkDFilterCount(dfilter, 0)
+
+    def test_matches_literal_caseless(self, checkDFilterCount):
+        dfilter = 'http.user_agent matches "UPDATE"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_matches_regex_1(self, checkDFilterCount):
+        dfilter = 'http.request.method matches "^h.ad$"'
+        checkDFilterCount(dfilter, 1)
@@ -63,6 +63,21 @@ class case_fileformat_pcap(subprocesstest.SubprocessTestCase):
             )
         self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
 
+    def test_pcap_zstd_direct(self, cmd_tshark, capture_file, features, fileformats_baseline_str):
+        '''Microsecond pcap direct vs Zstandard-compressed microsecond pcap direct'''
+        if not features.have_zstd:
+            self.skipTest('Requires Zstandard.')
+        # dhcp.pcap.zst is made of two frames, and two-pass reading seeks
+        # back into them.
+        capture_proc = self.assertRun((cmd_tshark,
+                '-r', capture_file('dhcp.pcap.zst'),
+                '-2',
+                '-Tfields',
+                '-e', 'frame.number', '-e', 'frame.time_epoch', '-e', 'frame.time_delta',
+                ),
+            )
+        self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
@@ -246,3 +261,67 @@ class case_fileformat_mime(subprocesstest.SubprocessTestCase):
                 '-Tfields', '-e', 'frame.len', '-e', 'pcapng.block.length',
             ))
         self.assertEqual(proc.stdout_str.strip(), '480\t128,128,88,88,132,132,132,132')
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_fileformat_editcap_dedup(subprocesstest.SubprocessTestCase):
+    def concatenated_dhcp(self, cmd_mergecap, capture_file):
+        # Eight packets, each one a copy of the packet four before it.
+        infile = self.filename_from_id('dhcp-twice.pcap')
+        self.assertRun((cmd_mergecap,
+            '-a', '-F', 'pcap', '-w', infile,
+            capture_file('dhcp.pcap'), capture_file('dhcp.pcap'),
+        ))
+        return infile
+
+    def ttl_copies(self, pcapgen):
+        # An IPv4 packet and an IPv6 packet, each seen twice with a
+        # different TTL or hop limit, as on both sides of a router.
+        infile = self.filename_from_id('ttl-copies.pcap')
+        payload = b'ping'
+        udp = pcapgen.udp(5001, 5002, len(payload)) + payload
+        packets = []
+        for ttl in (64, 63):
+            ip = pcapgen.ipv4(bytes((192, 0, 2, 1)), bytes((198, 51, 100, 1)),
+                              pcapgen.IPPROTO_UDP, len(udp), ttl=ttl, ident=1, flags_frag=0)
+            packets.append(pcapgen.ethernet(pcapgen.ETHERTYPE_IPV4) + ip + udp)
+        for hop_limit in (64, 63):
+            ip6 = pcapgen.ipv6(bytes.fromhex('20010db8000000000000000000000001'),
+                               bytes.fromhex('20010db8000000000000000000000002'),
+                               pcapgen.IPPROTO_UDP, len(udp), hop_limit=hop_limit)
+            packets.append(pcapgen.ethernet(pcapgen.ETHERTYPE_IPV6) + ip6 + udp)
+        with open(infile, 'wb') as f:
+            pcapgen.write_header(f)
+            for usecs, packet in enumerate(packets):
+                pcapgen.write_packet(f, usecs, packet)
+        return infile
+
+    def frame_count(self, cmd_tshark, outfile):
+        proc = self.assertRun((cmd_tshark, '-r', outfile, '-Tfields', '-e', 'frame.number'))
+        return len(proc.stdout_str.split())
+
+    def test_editcap_dedup_window(self, cmd_editcap, cmd_mergecap, cmd_tshark, capture_file):
+        '''Duplicates within the packet window are removed.'''
+        infile = self.concatenated_dhcp(cmd_mergecap, capture_file)
+        outfile = self.filename_from_id('dhcp-dedup.pcap')
+        self.assertRun((cmd_editcap, '-D', '5', infile, outfile))
+        self.assertEqual(self.frame_count(cmd_tshark, outfile), 4)
+        self.assertRun((cmd_editcap, '-D', '4', infile, outfile))
+        self.assertEqual(self.frame_count(cmd_tshark, outfile), 8)
+
+    def test_editcap_dedup_time_window(self, cmd_editcap, cmd_mergecap, cmd_tshark, capture_file):
+        '''Duplicates within the time window are removed.'''
+        infile = self.concatenated_dhcp(cmd_mergecap, capture_file)
+        outfile = self.filename_from_id('dhcp-dedup.pcap')
+        self.assertRun((cmd_editcap, '-w', '0.001', infile, outfile))
+        self.assertEqual(self.frame_count(cmd_tshark, outfile), 4)
+
+    def test_editcap_dedup_skip_ip_ttl(self, cmd_editcap, cmd_tshark, pcapgen):
+        '''Copies differing only in IP TTL or hop limit are duplicates with --skip-ip-ttl.'''
+        infile = self.ttl_copies(pcapgen)
+        outfile = self.filename_from_id('ttl-dedup.pcap')
+        self.assertRun((cmd_editcap, '-D', '5', infile, outfile))
+        self.assertEqual(self.frame_count(cmd_tshark, outfile), 4)
+        self.assertRun((cmd_editcap, '-D', '5', '--skip-ip-ttl', infile, outfile))
+        self.assertEqual(self.frame_count(cmd_tshark, outfile), 2)
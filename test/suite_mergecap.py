@@ -121,6 +121,25 @@ class case_mergecap_pcap(subprocesstest.SubprocessTestCase):
         ))
         check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 62, 1, 62)
 
+    def test_mergecap_many_pcap_pcap(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Merge many pcap files to pcap in chronological order'''
+        testout_file = self.filename_from_id(testout_pcap)
+        in_files = [capture_file('dhcp.pcap')] * 5 + [
+            capture_file('empty.pcap'), capture_file('rsasnakeoil2.pcap'),
+            capture_file('dhcp-nanosecond.pcap'), capture_file('empty.pcap'),
+        ]
+        mergecap_proc = self.assertRun([cmd_mergecap,
+            '-v',
+            '-F', 'pcap',
+            '-w', testout_file,
+        ] + in_files)
+        check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 82, 1, 82)
+        tshark_proc = self.assertRun((cmd_tshark,
+            '-r', testout_file,
+            '-Tfields', '-e', 'frame.time_delta',
+        ))
+        self.assertFalse(any(delta.startswith('-') for delta in tshark_proc.stdout_str.split()))
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
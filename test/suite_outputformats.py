@@ -93,3 +93,24 @@ class case_outputformats(subprocesstest.SubprocessTestCase):
         ''' Check that the option -j works with -Tek.'''
         check_outputformat("ek", extra_args=['-j', 'dhcp'], expected="dhcp-filter.ek",
             multiline=True)
+
+    def test_outputformat_fields_labels(self, cmd_tshark, capture_file):
+        '''Checks that -Tfields prints the same values whether or not the item labels are filled in.'''
+        # Fields that occur several times per packet, in nested subtrees.
+        field_sets = (
+            ('dns+icmp.pcapng.gz', ['-e', 'ip.addr', '-e', 'dns.qry.name',
+                                    '-e', 'dns.resp.name', '-e', 'dns.a',
+                                    '-e', 'dns.resp.ttl']),
+            ('dhcp.pcap', ['-e', 'dhcp.option.type', '-e', 'dhcp.option.length',
+                           '-e', 'dhcp.option.value']),
+        )
+        for pcap_file, fields in field_sets:
+            for occurrence in ('a', 'f', 'l', '2'):
+                args = [cmd_tshark, '-r', capture_file(pcap_file), '-T', 'fields',
+                        '-E', 'occurrence=' + occurrence]
+                values_proc = self.assertRun(args + fields)
+                # "frame" is printed using its label, so this fills them in.
+                labels_proc = self.assertRun(args + ['-e', 'frame'] + fields)
+                labels_values = [line.split('\t', 1)[1]
+                                 for line in labels_proc.stdout_str.splitlines()]
+                self.assertEqual(values_proc.stdout_str.splitlines(), labels_values)
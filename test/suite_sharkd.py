@@ -25,9 +25,9 @@ def cmd_sharkd(program):
 def run_sharkd_session(cmd_sharkd, request):
     self = request.instance
 
-    def run_sharkd_session_real(sharkd_commands):
+    def run_sharkd_session_real(sharkd_commands, sharkd_args=('-',)):
         sharkd_proc = self.startProcess(
-            (cmd_sharkd, '-'), stdin=subprocess.PIPE)
+            (cmd_sharkd,) + tuple(sharkd_args), stdin=subprocess.PIPE)
         sharkd_proc.stdin.write('\n'.join(sharkd_commands).encode('utf8'))
         self.waitProcess(sharkd_proc)
 
@@ -51,9 +51,9 @@ def run_sharkd_session(cmd_sharkd, request):
 def check_sharkd_session(run_sharkd_session, request):
     self = request.instance
 
-    def check_sharkd_session_real(sharkd_commands, expected_outputs):
+    def check_sharkd_session_real(sharkd_commands, expected_outputs, sharkd_args=('-',)):
         sharkd_commands = [json.dumps(x) for x in sharkd_commands]
-        actual_outputs = run_sharkd_session(sharkd_commands)
+        actual_outputs = run_sharkd_session(sharkd_commands, sharkd_args)
         self.assertEqual(expected_outputs, actual_outputs)
     return check_sharkd_session_real
 
@@ -85,6 +85,30 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                 "filename": "dhcp.pcap", "filesize": 1400},
         ))
 
+    def test_sharkd_read_file(self, check_sharkd_session, capture_file):
+        # -r loads the file before the first request; no "load" needed.
+        frame = lambda num: {
+            "c": MatchList(MatchAny(str)),
+            "num": num,
+            "bg": MatchAny(str),
+            "fg": MatchAny(str),
+        }
+        check_sharkd_session((
+            {"req": "status"},
+            {"req": "frames"},
+        ), (
+            {"frames": 4, "duration": 0.070345000,
+                "filename": "dhcp.pcap", "filesize": 1400},
+            [frame(1), frame(2), frame(3), frame(4)],
+        ), sharkd_args=('-r', capture_file('dhcp.pcap')))
+
+    def test_sharkd_read_file_classic(self, cmd_sharkd, capture_file):
+        # The classic command line takes no options.
+        sharkd_proc = self.assertRun(
+            (cmd_sharkd, '-', '-r', capture_file('dhcp.pcap')), expected_return=1)
+        self.assertIn("Options aren't supported with the classic command line",
+            sharkd_proc.stderr_str)
+
     def test_sharkd_req_analyse(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"req": "load", "file": capture_file('dhcp.pcap')},
@@ -169,6 +193,56 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             }),
         ))
 
+    def test_sharkd_req_frames_paging(self, check_sharkd_session, run_sharkd_session, capture_file):
+        # No., relative time, delta time displayed and a custom column.
+        columns = {"column0": "35", "column1": "38", "column2": "9", "column3": "ip.src:0"}
+        frames = lambda *rows: [{
+            "c": list(c),
+            "num": int(c[0]),
+            "bg": MatchAny(str),
+            "fg": MatchAny(str),
+        } for c in rows]
+        f1 = ("1", "0.000000", "0.000000", "0.0.0.0")
+        f2 = ("2", "0.000295", "0.000295", "192.168.0.1")
+        f3 = ("3", "0.070031", "0.069736", "0.0.0.0")
+        f4 = ("4", "0.070345", "0.000314", "192.168.0.1")
+        # These are asked for after the frames are cached with other
+        # previous displayed or reference frames, or other columns.
+        other_prev = dict(columns, filter="ip.src==192.168.0.1")
+        other_ref = dict(columns, refs="3")
+        other_columns = {"column0": "35", "column1": "ip.dst:0", "limit": 2}
+        load = {"req": "load", "file": capture_file('dhcp.pcap')}
+        check_sharkd_session((
+            load,
+            dict(columns, req="frames", limit=2),
+            dict(columns, req="frames", limit=2),
+            dict(columns, req="frames", skip=1, limit=1),
+            dict(columns, req="frames", skip=2),
+            dict(other_prev, req="frames"),
+            dict(other_ref, req="frames"),
+            dict(other_columns, req="frames"),
+            dict(columns, req="frames"),
+        ), (
+            {"err": 0},
+            frames(f1, f2),
+            frames(f1, f2),
+            frames(f2),
+            frames(f3, f4),
+            frames(("2", "0.000295", "0.000000", "192.168.0.1"),
+                   ("4", "0.070345", "0.070050", "192.168.0.1")),
+            frames(f1, f2, ("3", "*REF*", "*REF*", "0.0.0.0"),
+                   ("4", "0.000314", "0.000314", "192.168.0.1")),
+            frames(("1", "255.255.255.255"), ("2", "192.168.0.10")),
+            frames(f1, f2, f3, f4),
+        ))
+        # A fresh session, with nothing cached, gives the same columns.
+        for request in (other_prev, other_ref, other_columns):
+            cached = run_sharkd_session([json.dumps(x) for x in (
+                load, dict(columns, req="frames"), dict(request, req="frames"))])
+            fresh = run_sharkd_session([json.dumps(x) for x in (
+                load, dict(request, req="frames"))])
+            self.assertEqual(cached[-1], fresh[-1])
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
@@ -290,6 +364,21 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                 {"errmsg": 'Filter "garbage filter" is invalid - "filter" was unexpected in this context.'}]},
         ))
 
+    def test_sharkd_req_iograph_interval(self, check_sharkd_session, capture_file):
+        # Later requests for the same graphs are answered from the items
+        # collected for the first one.
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "iograph", "graph0": "packets", "graph1": "max:udp.length", "filter1": "udp.length"},
+            {"req": "iograph", "graph0": "packets", "graph1": "max:udp.length", "filter1": "udp.length", "interval": 10},
+            {"req": "iograph", "graph0": "packets", "interval": 35},
+        ), (
+            {"err": 0},
+            {"iograph": [{"items": [4.000000]}, {"items": [308.000000]}]},
+            {"iograph": [{"items": [2.000000, "7", 2.000000]}, {"items": [308.000000, "7", 308.000000]}]},
+            {"iograph": [{"items": [2.000000, "2", 2.000000]}]},
+        ))
+
     def test_sharkd_req_intervals_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"req": "load", "file": capture_file('dhcp.pcap')},
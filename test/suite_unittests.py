@@ -19,6 +19,10 @@ import fixtures
 
 @fixtures.uses_fixtures
 class case_unittests(subprocesstest.SubprocessTestCase):
+    def test_unit_cksum_test(self, program, base_env):
+        '''cksum_test'''
+        self.assertRun(program('cksum_test'), env=base_env)
+
     def test_unit_exntest(self, program, base_env):
         '''exntest'''
         self.assertRun(program('exntest'), env=base_env)
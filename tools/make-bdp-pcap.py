@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+#
+# Generate a capture file with one TCP flow that has a large amount of
+# data in flight.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Generate a capture file with one TCP flow that has a large amount of
+data in flight.
+
+The sender keeps a window's worth of segments unacknowledged, as a fast
+sender on a path with a high bandwidth-delay product would, which makes the
+file a stress test for TCP sequence analysis. Lost segments are seen by the
+capture but not by the receiver, which sends duplicate ACKs until the
+segment is retransmitted. Packets are truncated to their headers to keep
+the file small. For example:
+
+    tools/make-bdp-pcap.py --segments 2000000 --window 100000 bdp.pcap
+    time tshark -r bdp.pcap -o tcp.analyze_sequence_numbers:TRUE > /dev/null
+'''
+
+import argparse
+import sys
+
+import pcapgen
+
+CLIENT = (bytes((192, 0, 2, 1)), 5001)
+SERVER = (bytes((198, 51, 100, 1)), 40000)
+CLIENT_ISN = 0xfff00000     # Wraps early on
+SERVER_ISN = 1000
+ETH_IP_TCP_LEN = pcapgen.ETH_HEADER_LEN + pcapgen.IPV4_HEADER_LEN + pcapgen.TCP_HEADER_LEN
+
+def tcp_packet(src, dst, seq, ack, flags, payload_len):
+    return pcapgen.tcp_ipv4_packet(src[0], src[1], dst[0], dst[1], seq, ack, flags, payload_len)
+
+def main():
+    parser = argparse.ArgumentParser(description='High bandwidth-delay product TCP flow generator')
+    parser.add_argument('-n', '--segments', type=int, default=1000000, help='Number of data segments.')
+    parser.add_argument('-w', '--window', type=int, default=100000, help='Segments in flight.')
+    parser.add_argument('-m', '--mss', type=int, default=1448, help='Segment size.')
+    parser.add_argument('-l', '--loss-every', type=int, default=0,
+                        help='Lose every Nth segment (0 for no loss).')
+    parser.add_argument('output', help='Output pcap file.')
+    args = parser.parse_args()
+
+    if args.segments < 1 or args.window < 1 or not 1 <= args.mss <= 65495 or args.loss_every < 0:
+        sys.stderr.write('Invalid arguments.\n')
+        sys.exit(1)
+
+    syn, ack_flag, psh = pcapgen.TCP_SYN, pcapgen.TCP_ACK, pcapgen.TCP_PSH
+    usecs = 0
+    with open(args.output, 'wb') as out:
+        def write(pkt_len):
+            nonlocal usecs
+            pkt, orig_len = pkt_len
+            pcapgen.write_packet(out, usecs, pkt, orig_len)
+            usecs += 1
+
+        # Headers only.
+        pcapgen.write_header(out, snaplen=ETH_IP_TCP_LEN)
+
+        write(tcp_packet(CLIENT, SERVER, CLIENT_ISN, 0, syn, 0))
+        write(tcp_packet(SERVER, CLIENT, SERVER_ISN, CLIENT_ISN + 1, syn | ack_flag, 0))
+        write(tcp_packet(CLIENT, SERVER, CLIENT_ISN + 1, SERVER_ISN + 1, ack_flag, 0))
+
+        def seg_seq(i):
+            return CLIENT_ISN + 1 + i * args.mss
+
+        lost = set()
+        received = set()
+        rcv_next = 0        # First segment the receiver hasn't got
+        dupacks = 0
+
+        def receive(j):
+            nonlocal rcv_next, dupacks
+            if j in lost:
+                return
+            received.add(j)
+            old_next = rcv_next
+            while rcv_next in received:
+                received.discard(rcv_next)
+                rcv_next += 1
+            dupacks = dupacks + 1 if rcv_next == old_next else 0
+            write(tcp_packet(SERVER, CLIENT, SERVER_ISN + 1, seg_seq(rcv_next), ack_flag, 0))
+            if dupacks == 3 and rcv_next in lost:
+                # Fast retransmission
+                lost.discard(rcv_next)
+                write(tcp_packet(CLIENT, SERVER, seg_seq(rcv_next), SERVER_ISN + 1,
+                                 ack_flag | psh, args.mss))
+                received.add(rcv_next)
+
+        for i in range(args.segments):
+            if args.loss_every and i % args.loss_every == args.loss_every - 1:
+                lost.add(i)
+            write(tcp_packet(CLIENT, SERVER, seg_seq(i), SERVER_ISN + 1, ack_flag | psh, args.mss))
+            if i >= args.window:
+                receive(i - args.window)
+        for j in range(max(0, args.segments - args.window), args.segments):
+            receive(j)
+
+if __name__ == '__main__':
+    main()
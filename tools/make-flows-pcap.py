@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+#
+# Generate a capture file with a large number of concurrent TCP flows.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Generate a capture file with a large number of concurrent TCP flows.
+
+Every flow does a three-way handshake, and the handshakes are interleaved
+so that all of the flows are open at the same time, which makes the file
+a stress test for conversation lookups. For example:
+
+    tools/make-flows-pcap.py --flows 5000000 flows.pcap
+    time tshark -r flows.pcap > /dev/null
+'''
+
+import argparse
+import sys
+
+import pcapgen
+
+SERVER_ADDR = bytes((192, 0, 2, 1))
+SERVER_PORT = 80
+# One client address per flow, from 10.0.0.0/8
+MAX_FLOWS = 1 << 24
+
+def client_endpoint(flow):
+    '''Give each flow its own client address and port.'''
+    addr = bytes((10, (flow >> 16) & 0xff, (flow >> 8) & 0xff, flow & 0xff))
+    port = 1024 + flow % 50000
+    return addr, port
+
+def main():
+    parser = argparse.ArgumentParser(description='Concurrent TCP flow capture generator')
+    parser.add_argument('-f', '--flows', type=int, default=1000000, help='Number of flows.')
+    parser.add_argument('output', help='Output pcap file.')
+    args = parser.parse_args()
+
+    if args.flows < 1 or args.flows > MAX_FLOWS:
+        sys.stderr.write('The number of flows must be between 1 and {}.\n'.format(MAX_FLOWS))
+        sys.exit(1)
+
+    syn, ack = pcapgen.TCP_SYN, pcapgen.TCP_ACK
+    with open(args.output, 'wb') as out:
+        pcapgen.write_header(out)
+        usecs = 0
+        for step in range(3):
+            for flow in range(args.flows):
+                client, cport = client_endpoint(flow)
+                if step == 0:
+                    pkt, _ = pcapgen.tcp_ipv4_packet(client, cport, SERVER_ADDR, SERVER_PORT, 1000, 0, syn)
+                elif step == 1:
+                    pkt, _ = pcapgen.tcp_ipv4_packet(SERVER_ADDR, SERVER_PORT, client, cport, 5000, 1001, syn | ack)
+                else:
+                    pkt, _ = pcapgen.tcp_ipv4_packet(client, cport, SERVER_ADDR, SERVER_PORT, 1001, 5001, ack)
+                pcapgen.write_packet(out, usecs, pkt)
+                usecs += 1
+
+if __name__ == '__main__':
+    main()
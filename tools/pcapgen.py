@@ -0,0 +1,80 @@
+#
+# Helpers for writing synthetic capture files.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Helpers for writing synthetic capture files.
+
+Builds Ethernet, IPv4, IPv6, UDP and TCP headers and writes them to
+standard pcap files with microsecond time stamps. Used by the capture file
+generators in this directory and by the test suite.
+'''
+
+import struct
+
+ETHERTYPE_IPV4 = 0x0800
+ETHERTYPE_IPV6 = 0x86dd
+IPPROTO_TCP = 6
+IPPROTO_UDP = 17
+LINKTYPE_ETHERNET = 1
+
+ETH_HEADER_LEN = 14
+IPV4_HEADER_LEN = 20
+IPV6_HEADER_LEN = 40
+UDP_HEADER_LEN = 8
+TCP_HEADER_LEN = 20
+
+# Documentation addresses (RFC 7042)
+ETH_SRC = b'\x00\x00\x5e\x00\x53\x01'
+ETH_DST = b'\x00\x00\x5e\x00\x53\x02'
+
+TCP_SYN = 0x02
+TCP_PSH = 0x08
+TCP_ACK = 0x10
+
+def ip_checksum(header):
+    '''Returns the Internet checksum of an IPv4 header.'''
+    total = sum(struct.unpack('!{}H'.format(len(header) // 2), header))
+    while total >> 16:
+        total = (total & 0xffff) + (total >> 16)
+    return ~total & 0xffff
+
+def ethernet(ethertype):
+    return ETH_DST + ETH_SRC + struct.pack('!H', ethertype)
+
+def ipv4(src, dst, proto, payload_len, ttl=64, ident=0, flags_frag=0x4000):
+    '''Returns an IPv4 header, without options, with a valid checksum.'''
+    ip = struct.pack('!BBHHHBBH4s4s', 0x45, 0, IPV4_HEADER_LEN + payload_len, ident,
+                     flags_frag, ttl, proto, 0, src, dst)
+    return ip[:10] + struct.pack('!H', ip_checksum(ip)) + ip[12:]
+
+def ipv6(src, dst, next_header, payload_len, hop_limit=64):
+    return struct.pack('!IHBB16s16s', 0x60000000, payload_len, next_header, hop_limit, src, dst)
+
+def udp(sport, dport, payload_len):
+    '''Returns a UDP header, with no checksum.'''
+    return struct.pack('!HHHH', sport, dport, UDP_HEADER_LEN + payload_len, 0)
+
+def tcp(sport, dport, seq, ack, flags, window=65535):
+    '''Returns a TCP header, without options or checksum.'''
+    return struct.pack('!HHIIBBHHH', sport, dport, seq & 0xffffffff, ack & 0xffffffff,
+                       5 << 4, flags, window, 0, 0)
+
+def tcp_ipv4_packet(src, sport, dst, dport, seq, ack, flags, payload_len=0):
+    '''Returns the headers of an Ethernet/IPv4/TCP packet, and the length
+    of the packet with its payload_len bytes of payload.'''
+    headers = (ethernet(ETHERTYPE_IPV4) +
+               ipv4(src, dst, IPPROTO_TCP, TCP_HEADER_LEN + payload_len) +
+               tcp(sport, dport, seq, ack, flags))
+    return headers, len(headers) + payload_len
+
+def write_header(out, snaplen=65535, linktype=LINKTYPE_ETHERNET):
+    '''Writes a standard pcap file header, with microsecond time stamps.'''
+    out.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, snaplen, linktype))
+
+def write_packet(out, usecs, data, orig_len=None):
+    '''Writes a packet record, time stamped usecs after the epoch.'''
+    if orig_len is None:
+        orig_len = len(data)
+    out.write(struct.pack('<IIII', usecs // 1000000, usecs % 1000000, len(data), orig_len))
+    out.write(data)
@@ -3216,6 +3216,12 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    /* If we're printing selected fields, we only need their values,
+       unless some of them are printed using their label; don't bother
+       filling in the label of every item. */
+    if (print_packet_info && output_action == WRITE_FIELDS)
+      epan_dissect_skip_labels(edt, !output_fields_need_labels(output_fields));
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3816,6 +3822,12 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    /* If we're printing selected fields, we only need their values,
+       unless some of them are printed using their label; don't bother
+       filling in the label of every item. */
+    if (print_packet_info && output_action == WRITE_FIELDS)
+      epan_dissect_skip_labels(edt, !output_fields_need_labels(output_fields));
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
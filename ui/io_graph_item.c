@@ -34,6 +34,149 @@ int get_io_graph_index(packet_info *pinfo, int interval) {
     return (int) ((time_delta.secs*1000 + time_delta.nsecs/1000000) / interval);
 }
 
+guint32 get_io_graph_base_interval(guint32 interval, io_graph_item_unit_t item_unit, const nstime_t *duration, int max_items)
+{
+    guint64 duration_ms = 0;
+    guint32 base_interval;
+
+    if (item_unit == IOG_ITEM_UNIT_CALC_LOAD) {
+        return interval;
+    }
+
+    if (duration && duration->secs >= 0) {
+        duration_ms = (guint64) duration->secs * 1000 + duration->nsecs / 1000000;
+    }
+
+    for (base_interval = 1; base_interval < interval;
+         base_interval = get_io_graph_next_base_interval(base_interval, interval)) {
+        if (duration_ms / base_interval < (guint64) max_items) {
+            return base_interval;
+        }
+    }
+    return interval;
+}
+
+guint32 get_io_graph_next_base_interval(guint32 base_interval, guint32 interval)
+{
+    guint64 next_interval = (guint64) base_interval * 10;
+
+    if (next_interval < interval && interval % next_interval == 0) {
+        return (guint32) next_interval;
+    }
+    return interval;
+}
+
+/*
+ * Add the values of src to dst, as if the packets counted in src had been
+ * counted in dst. Ties between equal extreme values go to the earlier
+ * frame, which is the one update_io_graph_item() would have kept.
+ */
+static void
+merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, int ftype, io_graph_item_unit_t item_unit)
+{
+    int max_cmp = 0;
+    int min_cmp = 0;
+
+    if (src->first_frame_in_invl != 0 &&
+        (dst->first_frame_in_invl == 0 || src->first_frame_in_invl < dst->first_frame_in_invl)) {
+        dst->first_frame_in_invl = src->first_frame_in_invl;
+    }
+    if (src->last_frame_in_invl > dst->last_frame_in_invl) {
+        dst->last_frame_in_invl = src->last_frame_in_invl;
+    }
+
+    if (src->fields != 0) {
+        switch (ftype) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+            max_cmp = ((guint64)src->int_max > (guint64)dst->int_max) - ((guint64)src->int_max < (guint64)dst->int_max);
+            min_cmp = ((guint64)src->int_min > (guint64)dst->int_min) - ((guint64)src->int_min < (guint64)dst->int_min);
+            break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            max_cmp = (src->int_max > dst->int_max) - (src->int_max < dst->int_max);
+            min_cmp = (src->int_min > dst->int_min) - (src->int_min < dst->int_min);
+            break;
+        case FT_FLOAT:
+            max_cmp = (src->float_max > dst->float_max) - (src->float_max < dst->float_max);
+            min_cmp = (src->float_min > dst->float_min) - (src->float_min < dst->float_min);
+            break;
+        case FT_DOUBLE:
+            max_cmp = (src->double_max > dst->double_max) - (src->double_max < dst->double_max);
+            min_cmp = (src->double_min > dst->double_min) - (src->double_min < dst->double_min);
+            break;
+        case FT_RELATIVE_TIME:
+            max_cmp = nstime_cmp(&src->time_max, &dst->time_max);
+            min_cmp = nstime_cmp(&src->time_min, &dst->time_min);
+            break;
+        default:
+            break;
+        }
+
+        if (dst->fields == 0) {
+            /* First values seen, take them as they are. */
+            max_cmp = 1;
+            min_cmp = -1;
+        }
+        if (max_cmp > 0) {
+            dst->int_max = src->int_max;
+            dst->float_max = src->float_max;
+            dst->double_max = src->double_max;
+            dst->time_max = src->time_max;
+        }
+        if (min_cmp < 0) {
+            dst->int_min = src->int_min;
+            dst->float_min = src->float_min;
+            dst->double_min = src->double_min;
+            dst->time_min = src->time_min;
+        }
+        if ((item_unit == IOG_ITEM_UNIT_CALC_MAX &&
+             (max_cmp > 0 || (max_cmp == 0 && src->extreme_frame_in_invl < dst->extreme_frame_in_invl))) ||
+            (item_unit == IOG_ITEM_UNIT_CALC_MIN &&
+             (min_cmp < 0 || (min_cmp == 0 && src->extreme_frame_in_invl < dst->extreme_frame_in_invl)))) {
+            dst->extreme_frame_in_invl = src->extreme_frame_in_invl;
+        }
+    }
+
+    dst->frames     += src->frames;
+    dst->bytes      += src->bytes;
+    dst->fields     += src->fields;
+    dst->int_tot    += src->int_tot;
+    dst->float_tot  += src->float_tot;
+    dst->double_tot += src->double_tot;
+    nstime_add(&dst->time_tot, &src->time_tot);
+}
+
+int rollup_io_graph_items(io_graph_item_t *dst, const io_graph_item_t *src, int count, int factor, int hf_index, io_graph_item_unit_t item_unit)
+{
+    int ftype = hf_index >= 0 ? proto_registrar_get_ftype(hf_index) : FT_NONE;
+    int src_idx, dst_idx, end_idx, i;
+
+    for (src_idx = 0, dst_idx = 0; src_idx < count; src_idx += factor, dst_idx++) {
+        /* Build the item aside, since dst[dst_idx] may be src[src_idx]. */
+        io_graph_item_t item = src[src_idx];
+
+        end_idx = MIN(src_idx + factor, count);
+        for (i = src_idx + 1; i < end_idx; i++) {
+            merge_io_graph_item(&item, &src[i], ftype, item_unit);
+        }
+        dst[dst_idx] = item;
+    }
+    return dst_idx;
+}
+
 GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_unit_t item_unit)
 {
     GString *err_str = NULL;
@@ -103,6 +103,47 @@ reset_io_graph_items(io_graph_item_t *items, gsize count) {
  */
 int get_io_graph_index(packet_info *pinfo, int interval);
 
+/** Get the interval at which to collect items for a graph
+ *
+ * Items are collected at the finest power of ten number of milliseconds
+ * that divides interval and that covers duration in fewer than max_items
+ * items, so that the graph can later be shown at any multiple of it
+ * without retapping. LOAD items are always collected at interval, since
+ * each packet is spread across every item its response time overlaps.
+ *
+ * @param interval [in] Timing interval in ms.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @param duration [in] Time span of the packets, or NULL if unknown.
+ * @param max_items [in] The maximum number of items to collect.
+ * @return The interval in ms at which to collect items.
+ */
+guint32 get_io_graph_base_interval(guint32 interval, io_graph_item_unit_t item_unit, const nstime_t *duration, int max_items);
+
+/** Get the next coarser interval at which to collect items
+ *
+ * @param base_interval [in] The current collection interval in ms.
+ * @param interval [in] Timing interval in ms.
+ * @return The next power of ten multiple of base_interval that divides
+ *         interval, or interval itself.
+ */
+guint32 get_io_graph_next_base_interval(guint32 base_interval, guint32 interval);
+
+/** Combine runs of consecutive items into items for a coarser interval
+ *
+ * Item i of dst is the combination of items i*factor to i*factor+factor-1
+ * of src, as if its packets had been tapped at factor times the interval.
+ * dst may be the same array as src.
+ *
+ * @param dst [out] Array receiving the combined items.
+ * @param src [in] Array containing the items to combine.
+ * @param count [in] The number of items in src.
+ * @param factor [in] The number of src items per dst item.
+ * @param hf_index [in] Header field index for advanced statistics.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @return The number of items written to dst.
+ */
+int rollup_io_graph_items(io_graph_item_t *dst, const io_graph_item_t *src, int count, int factor, int hf_index, io_graph_item_unit_t item_unit);
+
 /** Check field and item unit compatibility
  *
  * @param field_name [in] Header field name to check
@@ -1229,8 +1229,7 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
-                if (iog->visible()) {
+                if (iog->setInterval(interval) && iog->visible()) {
                     need_retap = true;
                 }
             }
@@ -1239,6 +1238,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1588,6 +1589,11 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
+    interval_(0),
+    base_interval_(0),
+    base_cur_idx_(-1),
+    rollup_dirty_idx_(max_io_items_),
+    items_(base_items_),
     cur_idx_(-1)
 {
     Q_ASSERT(parent_ != NULL);
@@ -1889,8 +1895,13 @@ int IOGraph::packetFromTime(double ts)
 
 void IOGraph::clearAllData()
 {
+    base_interval_ = get_io_graph_base_interval(interval_, val_units_, NULL, max_io_items_);
+    base_cur_idx_ = -1;
+    reset_io_graph_items(base_items_, max_io_items_);
+    rollup_dirty_idx_ = max_io_items_;
+    rollup_items_.clear();
+    items_ = base_items_;
     cur_idx_ = -1;
-    reset_io_graph_items(items_, max_io_items_);
     if (graph_) {
         graph_->data()->clear();
     }
@@ -1908,6 +1919,8 @@ void IOGraph::recalcGraphData(capture_file *cap_file, bool enable_scaling)
     double mavg_cumulated = 0;
     QCPAxis *x_axis = nullptr;
 
+    updateRollup();
+
     if (graph_) {
         graph_->data()->clear();
         x_axis = graph_->keyAxis();
@@ -2134,9 +2147,66 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+// Returns true if the graph has to be retapped for the new interval.
+bool IOGraph::setInterval(int interval)
 {
+    if (interval == interval_) {
+        return false;
+    }
     interval_ = interval;
+
+    if (base_cur_idx_ < 0) {
+        // Nothing tapped yet, so we can start over at any interval.
+        base_interval_ = get_io_graph_base_interval(interval_, val_units_, NULL, max_io_items_);
+        rollup_dirty_idx_ = max_io_items_;
+        return true;
+    }
+
+    if (interval_ % base_interval_ == 0) {
+        rollup_dirty_idx_ = 0;
+        return false;
+    }
+    return true;
+}
+
+// Roll the base items up into coarser ones when a packet falls past the
+// last item, so that we keep covering the whole capture.
+void IOGraph::coarsenBaseItems()
+{
+    int next_interval = get_io_graph_next_base_interval(base_interval_, interval_);
+    int count = rollup_io_graph_items(base_items_, base_items_, base_cur_idx_ + 1,
+                                      next_interval / base_interval_, hf_index_, val_units_);
+
+    reset_io_graph_items(&base_items_[count], base_cur_idx_ + 1 - count);
+    base_interval_ = next_interval;
+    base_cur_idx_ = count - 1;
+    rollup_dirty_idx_ = 0;
+}
+
+// Bring the items we show up to date with the base items.
+void IOGraph::updateRollup()
+{
+    if (base_interval_ <= 0 || interval_ == base_interval_ || interval_ % base_interval_ != 0) {
+        // Either we tapped at our interval, or we're waiting for a retap.
+        rollup_items_.clear();
+        items_ = base_items_;
+        cur_idx_ = base_cur_idx_;
+        rollup_dirty_idx_ = max_io_items_;
+        return;
+    }
+
+    int factor = interval_ / base_interval_;
+    int count = (base_cur_idx_ + factor) / factor;
+    int first = qMin(rollup_dirty_idx_ / factor, rollup_items_.size());
+
+    rollup_items_.resize(count);
+    if (first < count) {
+        rollup_io_graph_items(rollup_items_.data() + first, &base_items_[first * factor],
+                              base_cur_idx_ + 1 - first * factor, factor, hf_index_, val_units_);
+    }
+    items_ = rollup_items_.constData();
+    cur_idx_ = count - 1;
+    rollup_dirty_idx_ = max_io_items_;
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -2161,23 +2231,40 @@ void IOGraph::tapReset(void *iog_ptr)
 tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dissect_t *edt, const void *)
 {
     IOGraph *iog = static_cast<IOGraph *>(iog_ptr);
-    if (!pinfo || !iog) {
+    if (!pinfo || !iog || iog->base_interval_ <= 0) {
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    int idx = get_io_graph_index(pinfo, iog->interval_);
+    int idx = get_io_graph_index(pinfo, iog->base_interval_);
+    bool rollup = iog->interval_ % iog->base_interval_ == 0;
     bool recalc = false;
 
+    /* trade resolution for range before dropping packets */
+    while (idx >= max_io_items_ && rollup && iog->base_interval_ < iog->interval_) {
+        iog->coarsenBaseItems();
+        idx = get_io_graph_index(pinfo, iog->base_interval_);
+    }
+
     /* some sanity checks */
     if ((idx < 0) || (idx >= max_io_items_)) {
-        iog->cur_idx_ = max_io_items_ - 1;
+        iog->base_cur_idx_ = max_io_items_ - 1;
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    /* update num_items */
-    if (idx > iog->cur_idx_) {
-        iog->cur_idx_ = (guint32) idx;
-        recalc = true;
+    /* update num_items, recalculating when the graph gets a new item */
+    if (idx > iog->base_cur_idx_) {
+        int factor = rollup ? iog->interval_ / iog->base_interval_ : 1;
+        if (iog->base_cur_idx_ < 0 || idx / factor > iog->base_cur_idx_ / factor) {
+            recalc = true;
+        }
+        iog->base_cur_idx_ = idx;
+    }
+
+    /* LOAD also updates the items before this one */
+    if (iog->val_units_ == IOG_ITEM_UNIT_CALC_LOAD) {
+        iog->rollup_dirty_idx_ = 0;
+    } else if (idx < iog->rollup_dirty_idx_) {
+        iog->rollup_dirty_idx_ = idx;
     }
 
     /* set start time */
@@ -2194,7 +2281,7 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(iog->items_, idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    if (!update_io_graph_item(iog->base_items_, idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->base_interval_)) {
         return TAP_PACKET_DONT_REDRAW;
     }
 
@@ -26,6 +26,7 @@
 #include <QIcon>
 #include <QMenu>
 #include <QTextStream>
+#include <QVector>
 
 class QRubberBand;
 class QTimer;
@@ -65,7 +66,7 @@ public:
     const QString valueUnitField() { return vu_field_; }
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() { return moving_avg_period_; }
-    void setInterval(int interval);
+    bool setInterval(int interval);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() { return graph_; }
@@ -97,6 +98,8 @@ private:
     static void tapReset(void *iog_ptr);
     static tap_packet_status tapPacket(void *iog_ptr, packet_info *pinfo, epan_dissect_t *edt, const void *data);
     static void tapDraw(void *iog_ptr);
+    void coarsenBaseItems();
+    void updateRollup();
 
     void calculateScaledValueUnit();
     template<class DataMap> double maxValueFromGraphData(const DataMap &map);
@@ -119,7 +122,15 @@ private:
 
     // Cached data. We should be able to change the Y axis without retapping as
     // much as is feasible.
-    io_graph_item_t items_[max_io_items_];
+    // Packets are tapped into base_items_ at base_interval_, which divides
+    // interval_. The items shown are rolled up from them, so changing to
+    // any other multiple of base_interval_ doesn't require a retap.
+    io_graph_item_t base_items_[max_io_items_];
+    int base_interval_;
+    int base_cur_idx_;
+    int rollup_dirty_idx_; // First base item changed since the last rollup
+    QVector<io_graph_item_t> rollup_items_;
+    const io_graph_item_t *items_; // base_items_ or rollup_items_
     int cur_idx_;
 };
 
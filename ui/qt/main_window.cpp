@@ -1338,6 +1338,13 @@ bool MainWindow::saveCaptureFile(capture_file *cf, bool dont_reopen) {
         if (cf->unsaved_changes) {
             cf_write_status_t status;
 
+            if (cf->compression_type == WTAP_ZSTD_COMPRESSED) {
+                /* We can't write Zstandard-compressed files, so we can't
+                   save on top of the existing file; let the user choose
+                   another name and format. */
+                return saveAsCaptureFile(cf, FALSE, dont_reopen);
+            }
+
             /* This is not a temporary capture file, but it has unsaved
                changes, so saving it means doing a "safe save" on top
                of the existing file, in the same format - no UI needed
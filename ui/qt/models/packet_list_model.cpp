@@ -19,6 +19,7 @@
 #include <epan/prefs.h>
 
 #include "ui/packet_list_utils.h"
+#include "ui/progress_dlg.h"
 #include "ui/recent.h"
 
 #include <epan/color_filters.h>
@@ -36,6 +37,8 @@
 #include <QFontMetrics>
 #include <QModelIndex>
 #include <QElapsedTimer>
+#include <QRunnable>
+#include <QThreadPool>
 
 // Print timing information
 //#define DEBUG_PACKET_LIST_MODEL 1
@@ -71,7 +74,13 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
-    idle_dissection_row_(0)
+    sort_in_progress_(false),
+    sort_stop_flag_(FALSE),
+    idle_dissection_row_(0),
+    prefetch_first_(0),
+    prefetch_last_(-1),
+    prefetch_down_(true),
+    prefetch_pos_(0)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
     glbl_plist_model = this;
@@ -99,11 +108,13 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
             this, &PacketListModel::emitItemHeightChanged,
             Qt::QueuedConnection);
     idle_dissection_timer_ = new QElapsedTimer();
+    prefetch_timer_ = new QElapsedTimer();
 }
 
 PacketListModel::~PacketListModel()
 {
     delete idle_dissection_timer_;
+    delete prefetch_timer_;
 }
 
 void PacketListModel::setCaptureFile(capture_file *cf)
@@ -162,6 +173,8 @@ guint PacketListModel::recreateVisibleRows()
 }
 
 void PacketListModel::clear() {
+    // Abandon any sort in progress; its records are about to be deleted.
+    sort_stop_flag_ = TRUE;
     emit beginResetModel();
     qDeleteAll(physical_rows_);
     physical_rows_.resize(0);
@@ -172,6 +185,8 @@ void PacketListModel::clear() {
     max_row_height_ = 0;
     max_line_count_ = 1;
     idle_dissection_row_ = 0;
+    prefetch_first_ = 0;
+    prefetch_last_ = -1;
 }
 
 void PacketListModel::invalidateAllColumnStrings()
@@ -346,6 +361,8 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 {
     if (!cap_file_ || visible_rows_.count() < 1) return;
     if (column < 0) return;
+    // We process events while sorting, which might ask us to sort again.
+    if (sort_in_progress_) return;
 
     sort_column_ = column;
     text_sort_column_ = PacketListRecord::textColumn(column);
@@ -354,8 +371,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    // XXX Use updateProgress instead. We'd have to switch from std::sort to
-    // something we can interrupt.
     if (!col_title.isEmpty()) {
         QString busy_msg = tr("Sorting \"%1\"…").arg(col_title);
         wsApp->pushStatus(WiresharkApplication::BusyStatus, busy_msg);
@@ -363,33 +378,215 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     busy_timer_.start();
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    bool sorted = true;
+    if (text_sort_column_ < 0) {
+        // Column comes directly from frame data
+        std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    } else {
+        sorted = sortByColumnStrings(col_title);
+    }
 
-    emit beginResetModel();
-    visible_rows_.resize(0);
-    number_to_row_.fill(0);
-    foreach (PacketListRecord *record, physical_rows_) {
-        frame_data *fdata = record->frameData();
+    if (sorted) {
+        emit beginResetModel();
+        visible_rows_.resize(0);
+        number_to_row_.fill(0);
+        foreach (PacketListRecord *record, physical_rows_) {
+            frame_data *fdata = record->frameData();
 
-        if (fdata->passed_dfilter || fdata->ref_time) {
-            visible_rows_ << record;
-            if (number_to_row_.size() <= (int)fdata->num) {
-                number_to_row_.resize(fdata->num + 10000);
+            if (fdata->passed_dfilter || fdata->ref_time) {
+                visible_rows_ << record;
+                if (number_to_row_.size() <= (int)fdata->num) {
+                    number_to_row_.resize(fdata->num + 10000);
+                }
+                number_to_row_[fdata->num] = visible_rows_.count();
             }
-            number_to_row_[fdata->num] = visible_rows_.count();
         }
+        emit endResetModel();
     }
-    emit endResetModel();
 
     if (!col_title.isEmpty()) {
         wsApp->popStatus(WiresharkApplication::BusyStatus);
     }
 
-    if (cap_file_->current_frame) {
+    if (sorted && cap_file_ && cap_file_->current_frame) {
         emit goToPacket(cap_file_->current_frame->num);
     }
 }
 
+// The sort key of a record for a dissected column, extracted once so that
+// the comparisons don't need the record or its column strings.
+struct ColumnSortEntry {
+    PacketListRecord *record;
+    guint32 num;
+    bool num_val_ok;
+    double num_val;
+    QString text;
+};
+
+class ColumnSortLessThan
+{
+public:
+    ColumnSortLessThan(bool numeric, Qt::SortOrder order) :
+        numeric_(numeric),
+        order_(order)
+    {}
+
+    bool operator()(const ColumnSortEntry &e1, const ColumnSortEntry &e2) const
+    {
+        int cmp_val = 0;
+
+        if (numeric_) {
+            // Custom column with numeric data (or something like a port number).
+            if (!e1.num_val_ok && !e2.num_val_ok) {
+                cmp_val = 0;
+            } else if (!e1.num_val_ok || (e2.num_val_ok && e1.num_val < e2.num_val)) {
+                // either e1 is invalid (and sort it before others) or both
+                // e1 and e2 are valid (sort normally)
+                cmp_val = -1;
+            } else if (!e2.num_val_ok || (e1.num_val > e2.num_val)) {
+                cmp_val = 1;
+            }
+        } else {
+            cmp_val = e1.text.compare(e2.text);
+        }
+
+        if (cmp_val == 0) {
+            // All else being equal, compare frame numbers.
+            cmp_val = e1.num < e2.num ? -1 : (e1.num > e2.num ? 1 : 0);
+        }
+
+        if (order_ == Qt::AscendingOrder) {
+            return cmp_val < 0;
+        } else {
+            return cmp_val > 0;
+        }
+    }
+
+private:
+    bool numeric_;
+    Qt::SortOrder order_;
+};
+
+// Sorts a range of entries, or merges two sorted adjacent ranges.
+class ColumnSortTask : public QRunnable
+{
+public:
+    ColumnSortTask(ColumnSortEntry *first, ColumnSortEntry *middle, ColumnSortEntry *last,
+                   const ColumnSortLessThan &less_than) :
+        first_(first),
+        middle_(middle),
+        last_(last),
+        less_than_(less_than)
+    {}
+
+private:
+    ColumnSortEntry *first_;
+    ColumnSortEntry *middle_;
+    ColumnSortEntry *last_;
+    ColumnSortLessThan less_than_;
+
+    void run()
+    {
+        if (middle_) {
+            std::inplace_merge(first_, middle_, last_, less_than_);
+        } else {
+            std::sort(first_, last_, less_than_);
+        }
+    }
+};
+
+static progdlg_t *
+update_sort_progress(progdlg_t *progdlg, gboolean *stop_flag, const QString &col_title, gfloat progress)
+{
+    if (!progdlg) {
+        progdlg = delayed_create_progress_dlg(wsApp->mainWindow(), "Sorting", qUtf8Printable(col_title),
+                                              TRUE, stop_flag, progress);
+    } else {
+        update_progress_dlg(progdlg, progress, NULL);
+    }
+    return progdlg;
+}
+
+// Sort by a dissected column. Dissection isn't thread safe, so the column
+// strings are fetched here, once per record, and converted to numbers if
+// the column is numeric. The entries are then sorted in chunks by a thread
+// pool and the chunks merged, while we keep the UI responsive. The sort
+// can be stopped from the progress bar. Returns false if it was stopped.
+static const int parallel_sort_min_rows_ = 10000;
+bool PacketListModel::sortByColumnStrings(const QString &col_title)
+{
+    QVector<ColumnSortEntry> entries;
+    int row_count = physical_rows_.count();
+    progdlg_t *progdlg = NULL;
+
+    sort_in_progress_ = true;
+    sort_stop_flag_ = FALSE;
+
+    entries.resize(row_count);
+    ColumnSortEntry *entry = entries.data();
+    for (int row = 0; row < row_count; row++, entry++) {
+        if (busy_timer_.elapsed() > busy_timeout_) {
+            // Extracting the keys is most of the work when the strings
+            // aren't cached.
+            progdlg = update_sort_progress(progdlg, &sort_stop_flag_, col_title, (gfloat) row / row_count * 0.8f);
+            busy_timer_.restart();
+            if (sort_stop_flag_) break;
+        }
+
+        PacketListRecord *record = physical_rows_[row];
+        QString col_str = record->columnString(sort_cap_file_, sort_column_);
+        entry->record = record;
+        entry->num = record->frameData()->num;
+        if (sort_column_is_numeric_) {
+            entry->num_val = parseNumericColumn(col_str, &entry->num_val_ok);
+        } else {
+            entry->num_val_ok = false;
+            entry->text = col_str;
+        }
+    }
+
+    if (!sort_stop_flag_) {
+        ColumnSortLessThan less_than(sort_column_is_numeric_, sort_order_);
+        QThreadPool sort_pool;
+        int chunks = row_count < parallel_sort_min_rows_ ? 1 : qMax(1, sort_pool.maxThreadCount());
+        QVector<ColumnSortEntry *> bounds;
+        ColumnSortEntry *first = entries.data();
+
+        for (int i = 0; i <= chunks; i++) {
+            bounds << first + (qint64) row_count * i / chunks;
+        }
+
+        for (int i = 0; i < chunks; i++) {
+            sort_pool.start(new ColumnSortTask(bounds[i], NULL, bounds[i + 1], less_than));
+        }
+        for (int width = 1; ; width *= 2) {
+            while (!sort_pool.waitForDone(busy_timeout_)) {
+                progdlg = update_sort_progress(progdlg, &sort_stop_flag_, col_title, 0.9f);
+            }
+            if (width >= chunks) break;
+            for (int i = 0; i + width < chunks; i += 2 * width) {
+                sort_pool.start(new ColumnSortTask(bounds[i], bounds[i + width],
+                                                   bounds[qMin(i + 2 * width, chunks)], less_than));
+            }
+        }
+    }
+
+    // The model may have been cleared while we were processing events.
+    bool sorted = !sort_stop_flag_ && physical_rows_.count() >= row_count;
+    if (sorted) {
+        for (int row = 0; row < row_count; row++) {
+            physical_rows_[row] = entries[row].record;
+        }
+    }
+
+    if (progdlg) {
+        destroy_progress_dlg(progdlg);
+    }
+    sort_in_progress_ = false;
+
+    return sorted;
+}
+
 bool PacketListModel::isNumericColumn(int column)
 {
     if (column < 0) {
@@ -463,7 +660,8 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
 
     // Wherein we try to cram the logic of packet_list_compare_records,
     // _packet_list_compare_records, and packet_list_compare_custom from
-    // gtk/packet_list_store.c into one function
+    // gtk/packet_list_store.c into one function. Dissected columns are
+    // sorted by sortByColumnStrings instead.
 
     if (busy_timer_.elapsed() > busy_timeout_) {
         // What's the least amount of processing that we can do which will draw
@@ -474,37 +672,9 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     if (sort_column_ < 0) {
         // No column.
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-    } else if (text_sort_column_ < 0) {
+    } else {
         // Column comes directly from frame data
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
-    } else  {
-        if (r1->columnString(sort_cap_file_, sort_column_).constData() == r2->columnString(sort_cap_file_, sort_column_).constData()) {
-            cmp_val = 0;
-        } else if (sort_column_is_numeric_) {
-            // Custom column with numeric data (or something like a port number).
-            // Attempt to convert to numbers.
-            // XXX This is slow. Can we avoid doing this?
-            bool ok_r1, ok_r2;
-            double num_r1 = parseNumericColumn(r1->columnString(sort_cap_file_, sort_column_), &ok_r1);
-            double num_r2 = parseNumericColumn(r2->columnString(sort_cap_file_, sort_column_), &ok_r2);
-
-            if (!ok_r1 && !ok_r2) {
-                cmp_val = 0;
-            } else if (!ok_r1 || (ok_r2 && num_r1 < num_r2)) {
-                // either r1 is invalid (and sort it before others) or both
-                // r1 and r2 are valid (sort normally)
-                cmp_val = -1;
-            } else if (!ok_r2 || (num_r1 > num_r2)) {
-                cmp_val = 1;
-            }
-        } else {
-            cmp_val = r1->columnString(sort_cap_file_, sort_column_).compare(r2->columnString(sort_cap_file_, sort_column_));
-        }
-
-        if (cmp_val == 0) {
-            // All else being equal, compare column numbers.
-            cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), COL_NUMBER);
-        }
     }
 
     if (sort_order_ == Qt::AscendingOrder) {
@@ -676,8 +846,9 @@ void PacketListModel::flushVisibleRows()
     }
 }
 
-// Fill our column string and colorization cache while the application is
-// idle. Try to be as conservative with the CPU and disk as possible.
+// Fill our colorization cache while the application is idle. Try to be as
+// conservative with the CPU and disk as possible. Column strings are only
+// cached for the rows near the visible ones; see prefetchRows.
 static const int idle_dissection_interval_ = 5; // ms
 void PacketListModel::dissectIdle(bool reset)
 {
@@ -708,6 +879,63 @@ void PacketListModel::dissectIdle(bool reset)
     emit bgColorizationProgress(first+1, idle_dissection_row_+1);
 }
 
+// Dissect the rows around the visible ones in small slices while the
+// application is idle, so that they are ready by the time they are scrolled
+// into view. Rows in the direction the view is moving come first. This has
+// to run on the main thread, since dissection isn't thread safe.
+static const int prefetch_pages_ahead_ = 2;
+static const int prefetch_pages_behind_ = 1;
+void PacketListModel::prefetchRows(int first, int last)
+{
+    if (last < first) {
+        return;
+    }
+    if (first == prefetch_first_ && last == prefetch_last_) {
+        return;
+    }
+
+    bool idle = prefetch_pos_ >= (prefetch_pages_ahead_ + prefetch_pages_behind_) * (prefetch_last_ - prefetch_first_ + 1);
+    prefetch_down_ = first >= prefetch_first_;
+    prefetch_first_ = first;
+    prefetch_last_ = last;
+    prefetch_pos_ = 0;
+
+    if (idle) {
+        QTimer::singleShot(idle_dissection_interval_, this, SLOT(prefetchIdle()));
+    }
+}
+
+// The row to prefetch at position pos: first the rows ahead of the visible
+// ones, nearest first, then those behind them.
+int PacketListModel::prefetchRow(int pos) const
+{
+    int page = prefetch_last_ - prefetch_first_ + 1;
+
+    if (pos < page * prefetch_pages_ahead_) {
+        return prefetch_down_ ? prefetch_last_ + 1 + pos : prefetch_first_ - 1 - pos;
+    }
+    pos -= page * prefetch_pages_ahead_;
+    return prefetch_down_ ? prefetch_first_ - 1 - pos : prefetch_last_ + 1 + pos;
+}
+
+void PacketListModel::prefetchIdle()
+{
+    int count = (prefetch_pages_ahead_ + prefetch_pages_behind_) * (prefetch_last_ - prefetch_first_ + 1);
+
+    prefetch_timer_->start();
+    while (prefetch_timer_->elapsed() < idle_dissection_interval_ && prefetch_pos_ < count) {
+        int row = prefetchRow(prefetch_pos_);
+        if (row >= 0 && row < visible_rows_.count()) {
+            visible_rows_[row]->ensureColumnsCached(cap_file_);
+        }
+        prefetch_pos_++;
+    }
+
+    if (prefetch_pos_ < count) {
+        QTimer::singleShot(idle_dissection_interval_, this, SLOT(prefetchIdle()));
+    }
+}
+
 // XXX Pass in cinfo from packet_list_append so that we can fill in
 // line counts?
 gint PacketListModel::appendPacket(frame_data *fdata)
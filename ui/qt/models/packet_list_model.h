@@ -81,6 +81,12 @@ public slots:
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
     void flushVisibleRows();
     void dissectIdle(bool reset = false);
+    /**
+     * @brief Cache the column strings of the rows near the visible ones.
+     * @param first The first visible row.
+     * @param last The last visible row.
+     */
+    void prefetchRows(int first, int last);
 
 private:
     capture_file *cap_file_;
@@ -100,16 +106,27 @@ private:
     static capture_file *sort_cap_file_;
     static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
     static double parseNumericColumn(const QString &val, bool *ok);
+    bool sortByColumnStrings(const QString &col_title);
+    bool sort_in_progress_;
+    gboolean sort_stop_flag_;
 
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
+    QElapsedTimer *prefetch_timer_;
+    int prefetch_first_;
+    int prefetch_last_;
+    bool prefetch_down_;
+    int prefetch_pos_;
+    int prefetchRow(int pos) const;
+
     struct _GStringChunk *string_cache_pool_;
 
     bool isNumericColumn(int column);
 
 private slots:
     void emitItemHeightChanged(const QModelIndex &ih_index);
+    void prefetchIdle();
 };
 
 #endif // PACKET_LIST_MODEL_H
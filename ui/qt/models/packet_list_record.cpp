@@ -29,6 +29,10 @@ QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::col_data_ver_ = 1;
 unsigned PacketListRecord::rows_color_ver_ = 1;
 
+// Enough for a few hundred thousand typical rows.
+static const int column_cache_limit_ = 64 * 1024 * 1024; // bytes
+QCache<const PacketListRecord *, PacketListRecord::ColumnText> PacketListRecord::col_text_cache_(column_cache_limit_);
+
 PacketListRecord::PacketListRecord(frame_data *frameData) :
     fdata_(frameData),
     lines_(1),
@@ -43,7 +47,7 @@ PacketListRecord::PacketListRecord(frame_data *frameData) :
 
 PacketListRecord::~PacketListRecord()
 {
-    col_text_.clear();
+    col_text_cache_.remove(this);
 }
 
 void PacketListRecord::ensureColorized(capture_file *cap_file)
@@ -61,8 +65,23 @@ void PacketListRecord::ensureColorized(capture_file *cap_file)
     // to redissect it to colorize it.
     //
     bool dissect_color = !colorized_ || ( color_ver_ != rows_color_ver_ );
-    if (data_ver_ != col_data_ver_ || dissect_color) {
-        dissect(cap_file, dissect_color);
+    if (dissect_color) {
+        dissect(cap_file, false, dissect_color);
+    }
+}
+
+void PacketListRecord::ensureColumnsCached(capture_file *cap_file)
+{
+    Q_ASSERT(fdata_);
+
+    if (!cap_file) {
+        return;
+    }
+
+    bool dissect_columns = !col_text_cache_.contains(this) || data_ver_ != col_data_ver_;
+    bool dissect_color = !colorized_ || ( color_ver_ != rows_color_ver_ );
+    if (dissect_columns || dissect_color) {
+        dissect(cap_file, dissect_columns, dissect_color);
     }
 }
 
@@ -83,11 +102,18 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     // properly colorized?
     //
     bool dissect_color = ( colorized && !colorized_ ) || ( color_ver_ != rows_color_ver_ );
-    if (column >= col_text_.count() || col_text_.at(column).isNull() || data_ver_ != col_data_ver_ || dissect_color) {
-        dissect(cap_file, dissect_color);
+    // object() also marks the text as the most recently used.
+    ColumnText *col_text = col_text_cache_.object(this);
+    bool dissect_columns = !col_text || column >= col_text->count() || data_ver_ != col_data_ver_;
+    if (dissect_columns || dissect_color) {
+        dissect(cap_file, dissect_columns, dissect_color);
+        col_text = col_text_cache_.object(this);
     }
 
-    return col_text_.at(column);
+    if (!col_text || column >= col_text->count()) {
+        return QString();
+    }
+    return col_text->at(column);
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
@@ -108,7 +134,7 @@ void PacketListRecord::resetColumns(column_info *cinfo)
     }
 }
 
-void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
+void PacketListRecord::dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color)
 {
     // packet_list_store.c:packet_list_dissect_and_cache_record
     epan_dissect_t edt;
@@ -117,8 +143,6 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
     wtap_rec rec; /* Record metadata */
     Buffer buf;   /* Record data */
 
-    gboolean dissect_columns = col_text_.isEmpty() || data_ver_ != col_data_ver_;
-
     if (!cap_file) {
         return;
     }
@@ -206,7 +230,9 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
         colorized_ = true;
         color_ver_ = rows_color_ver_;
     }
-    data_ver_ = col_data_ver_;
+    if (dissect_columns) {
+        data_ver_ = col_data_ver_;
+    }
 
     struct conversation * conv = find_conversation_pinfo(&edt.pi, 0);
     conv_index_ = ! conv ? 0 : conv->conv_index;
@@ -216,7 +242,6 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
     wtap_rec_cleanup(&rec);
 }
 
-//#define MINIMIZE_STRING_COPYING 1
 void PacketListRecord::cacheColumnStrings(column_info *cinfo)
 {
     // packet_list_store.c:packet_list_change_record(PacketList *packet_list, PacketListRecord *record, gint col, column_info *cinfo)
@@ -224,70 +249,13 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         return;
     }
 
-    col_text_.clear();
+    ColumnText *col_text = new ColumnText;
     lines_ = 1;
     line_count_changed_ = false;
 
     for (int column = 0; column < cinfo->num_cols; ++column) {
         int col_lines = 1;
 
-#ifdef MINIMIZE_STRING_COPYING
-        int text_col = cinfo_column_.value(column, -1);
-
-        /* Column based on frame_data or it already contains a value */
-        if (text_col < 0) {
-            col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
-            col_text_ << QString(cinfo->columns[column].col_data);
-            continue;
-        }
-
-        switch (cinfo->col_fmt[column]) {
-        case COL_PROTOCOL:
-        case COL_INFO:
-        case COL_IF_DIR:
-        case COL_DCE_CALL:
-        case COL_8021Q_VLAN_ID:
-        case COL_EXPERT:
-        case COL_FREQ_CHAN:
-            if (cinfo->columns[column].col_data && cinfo->columns[column].col_data != cinfo->columns[column].col_buf) {
-                /* This is a constant string, so we don't have to copy it */
-                // XXX - ui/gtk/packet_list_store.c uses G_MAXUSHORT. We don't do proper UTF8
-                // truncation in either case.
-                int col_text_len = MIN(qstrlen(cinfo->col_data[column]) + 1, COL_MAX_INFO_LEN);
-                col_text_ << QString(QByteArray::fromRawData(cinfo->columns[column].col_data, col_text_len));
-                break;
-            }
-            /* !! FALL-THROUGH!! */
-
-        case COL_DEF_SRC:
-        case COL_RES_SRC:        /* COL_DEF_SRC is currently just like COL_RES_SRC */
-        case COL_UNRES_SRC:
-        case COL_DEF_DL_SRC:
-        case COL_RES_DL_SRC:
-        case COL_UNRES_DL_SRC:
-        case COL_DEF_NET_SRC:
-        case COL_RES_NET_SRC:
-        case COL_UNRES_NET_SRC:
-        case COL_DEF_DST:
-        case COL_RES_DST:        /* COL_DEF_DST is currently just like COL_RES_DST */
-        case COL_UNRES_DST:
-        case COL_DEF_DL_DST:
-        case COL_RES_DL_DST:
-        case COL_UNRES_DL_DST:
-        case COL_DEF_NET_DST:
-        case COL_RES_NET_DST:
-        case COL_UNRES_NET_DST:
-        default:
-            if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
-                /* Use the unresolved value in col_expr_val */
-                // XXX Use QContiguousCache?
-                col_text_ << QString(cinfo->col_expr.col_expr_val[column]);
-            } else {
-                col_text_ << QString(cinfo->columns[column].col_data);
-            }
-            break;
-        }
-#else // MINIMIZE_STRING_COPYING
         QString col_str;
         if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
             /* Use the unresolved value in col_expr_val */
@@ -301,14 +269,18 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
             col_str = QString(cinfo->columns[column].col_data);
         }
 
-        col_text_ << col_str;
+        col_text->append(col_str);
         col_lines = col_str.count('\n');
         if (col_lines > lines_) {
             lines_ = col_lines;
             line_count_changed_ = true;
         }
-#endif // MINIMIZE_STRING_COPYING
     }
+
+    // Replaces and deletes any older text. If the text is too large
+    // to be cached at all it is deleted right away.
+    col_text->squeeze();
+    col_text_cache_.insert(this, col_text, col_text->size());
 }
 
 /*
@@ -20,8 +20,10 @@
 #include <epan/packet.h>
 
 #include <QByteArray>
+#include <QCache>
 #include <QList>
 #include <QVariant>
+#include <QVarLengthArray>
 
 struct conversation;
 struct _GStringChunk;
@@ -34,6 +36,9 @@ public:
 
     // Ensure that the record is colorized.
     void ensureColorized(capture_file *cap_file);
+    // Ensure that the record's column strings are cached and that it is
+    // colorized, dissecting it at most once.
+    void ensureColumnsCached(capture_file *cap_file);
     // Return the string value for a column. Data is cached if possible.
     const QString columnString(capture_file *cap_file, int column, bool colorized = false);
     frame_data *frameData() const { return fdata_; }
@@ -43,7 +48,7 @@ public:
     unsigned int conversation() { return conv_index_; }
 
     int columnTextSize(const char *str);
-    static void invalidateAllRecords() { col_data_ver_++; }
+    static void invalidateAllRecords() { col_data_ver_++; col_text_cache_.clear(); }
     static void resetColumns(column_info *cinfo);
     static void resetColorization() { rows_color_ver_++; }
 
@@ -51,15 +56,33 @@ public:
     inline int lineCountChanged() { return line_count_changed_; }
 
 private:
-    /** The column text for some columns */
-    QStringList col_text_;
+    /** The column text of a record, in a single string */
+    class ColumnText {
+    public:
+        int count() const { return ends_.size(); }
+        QString at(int column) const {
+            int start = column > 0 ? ends_[column - 1] : 0;
+            return text_.mid(start, ends_[column] - start);
+        }
+        void append(const QString &str) { text_ += str; ends_.append(text_.size()); }
+        void squeeze() { text_.squeeze(); }
+        int size() const { return (int) sizeof(*this) + text_.capacity() * (int) sizeof(QChar); }
+
+    private:
+        QString text_;
+        /** The end of each column in text_ */
+        QVarLengthArray<int, 16> ends_;
+    };
+
+    /** The column text of recently used records */
+    static QCache<const PacketListRecord *, ColumnText> col_text_cache_;
 
     frame_data *fdata_;
     int lines_;
     bool line_count_changed_;
     static QMap<int, int> cinfo_column_;
 
-    /** Data versions. Used to invalidate col_text_ */
+    /** Data versions. Used to invalidate the cached column text */
     static unsigned col_data_ver_;
     unsigned data_ver_;
     /** Has this record been colorized? */
@@ -72,7 +95,7 @@ private:
 
     bool read_failed_;
 
-    void dissect(capture_file *cap_file, bool dissect_color = false);
+    void dissect(capture_file *cap_file, bool dissect_columns, bool dissect_color = false);
     void cacheColumnStrings(column_info *cinfo);
 };
 
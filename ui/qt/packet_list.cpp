@@ -281,6 +281,7 @@ PacketList::PacketList(QWidget *parent) :
             this, SLOT(sectionMoved(int,int,int)));
 
     connect(verticalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(vScrollBarActionTriggered(int)));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(prefetchVisibleRows()));
 }
 
 void PacketList::colorsChanged()
@@ -1839,6 +1840,18 @@ void PacketList::vScrollBarActionTriggered(int)
     scrollViewChanged(tail_at_end_);
 }
 
+// Let the model dissect the rows around the visible ones before they're
+// scrolled into view.
+void PacketList::prefetchVisibleRows()
+{
+    QModelIndex first_idx = indexAt(viewport()->rect().topLeft());
+    if (!first_idx.isValid()) return;
+
+    QModelIndex last_idx = indexAt(viewport()->rect().bottomLeft());
+    int last = last_idx.isValid() ? last_idx.row() : packet_list_model_->rowCount() - 1;
+    packet_list_model_->prefetchRows(first_idx.row(), last);
+}
+
 void PacketList::scrollViewChanged(bool at_end)
 {
     if (capture_in_progress_ && prefs.capture_auto_scroll) {
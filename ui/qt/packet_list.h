@@ -191,6 +191,7 @@ private slots:
     void updateRowHeights(const QModelIndex &ih_index);
     void copySummary();
     void vScrollBarActionTriggered(int);
+    void prefetchVisibleRows();
     void drawFarOverlay();
     void drawNearOverlay();
     void updatePackets(bool redraw);
@@ -1947,7 +1947,11 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 	/* Check whether we can open a capture file with that file type
 	   and that encapsulation, and, if the compression type isn't
 	   "uncompressed", whether we can write a *compressed* file
-	   of that file type. */
+	   of that file type.  We can only write gzip-compressed files. */
+	if (compression_type == WTAP_ZSTD_COMPRESSED) {
+		*err = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
+		return NULL;
+	}
 	if (!wtap_dump_open_check(file_type_subtype, params->encap,
 	    (compression_type != WTAP_UNCOMPRESSED), err))
 		return NULL;
@@ -22,11 +22,19 @@
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #ifdef HAVE_ZLIB
 #define ZLIB_CONST
 #include <zlib.h>
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+
 /*
  * See RFC 1952:
  *
@@ -34,6 +42,13 @@
  *
  * for a description of the gzip file format.
  *
+ * See RFC 8878:
+ *
+ *      https://tools.ietf.org/html/rfc8878
+ *
+ * for a description of the Zstandard format, which we can read but
+ * not write.
+ *
  * Some other compressed file formats we might want to support:
  *
  *      XZ format: https://tukaani.org/xz/
@@ -53,6 +68,9 @@ static struct compression_type {
 } compression_types[] = {
 #ifdef HAVE_ZLIB
     { WTAP_GZIP_COMPRESSED, "gz", "gzip compressed" },
+#endif
+#ifdef HAVE_ZSTD
+    { WTAP_ZSTD_COMPRESSED, "zst", "Zstandard compressed" },
 #endif
     { WTAP_UNCOMPRESSED, NULL, NULL }
 };
@@ -60,10 +78,11 @@ static struct compression_type {
 wtap_compression_type
 wtap_get_compression_type(wtap *wth)
 {
-	gboolean is_compressed;
+	FILE_T fh = (wth->fh == NULL) ? wth->random_fh : wth->fh;
 
-	is_compressed = file_iscompressed((wth->fh == NULL) ? wth->random_fh : wth->fh);
-	return is_compressed ? WTAP_GZIP_COMPRESSED : WTAP_UNCOMPRESSED;
+	if (!file_iscompressed(fh))
+		return WTAP_UNCOMPRESSED;
+	return fh->is_zstd ? WTAP_ZSTD_COMPRESSED : WTAP_GZIP_COMPRESSED;
 }
 
 const char *
@@ -111,7 +130,10 @@ typedef enum {
     UNCOMPRESSED,  /* uncompressed - copy input directly */
 #ifdef HAVE_ZLIB
     ZLIB,          /* decompress a zlib stream */
-    GZIP_AFTER_HEADER
+    GZIP_AFTER_HEADER,
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD,          /* decompress a Zstandard frame */
 #endif
 } compression_t;
 
@@ -135,6 +157,7 @@ struct wtap_reader {
     gint64 raw;                 /* where the raw data started, for seeking */
     compression_t compression;  /* type of compression, if any */
     gboolean is_compressed;     /* FALSE if completely uncompressed, TRUE otherwise */
+    gboolean is_zstd;           /* TRUE if Zstandard-compressed */
 
     /* seek request */
     gint64 skip;                /* amount to skip (already rewound if backwards) */
@@ -148,10 +171,19 @@ struct wtap_reader {
     /* zlib inflate stream */
     z_stream strm;              /* stream structure in-place (not a pointer) */
     gboolean dont_check_crc;    /* TRUE if we aren't supposed to check the CRC */
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstd_dctx;    /* Zstandard decompression context, allocated when needed */
 #endif
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+
+    /* memory-mapped file, if we're doing random access to a regular file;
+       while it's mapped, raw_pos is the position in the mapping, and the
+       file descriptor's own position isn't used */
+    guint8 *map;
+    gint64 map_size;
 };
 
 /* Current read offset within a buffer. */
@@ -190,12 +222,89 @@ buf_reset(struct wtap_reader_buf *buf)
     buf->avail = 0;
 }
 
+#ifdef HAVE_SYS_MMAN_H
+/*
+ * Map the entire file, replacing any existing mapping.  If that fails,
+ * we keep any existing mapping, or keep using read().
+ */
+static void
+map_file(FILE_T state)
+{
+    ws_statb64 st;
+    void *map;
+
+    if (ws_fstat64(state->fd, &st) == -1 || !S_ISREG(st.st_mode))
+        return;
+    if (st.st_size <= state->map_size || (guint64)st.st_size > G_MAXSIZE)
+        return;
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, state->fd, 0);
+    if (map == MAP_FAILED)
+        return;
+    if (state->map != NULL)
+        munmap(state->map, (size_t)state->map_size);
+    state->map = (guint8 *)map;
+    state->map_size = st.st_size;
+}
+
+static void
+unmap_file(FILE_T state)
+{
+    if (state->map != NULL) {
+        munmap(state->map, (size_t)state->map_size);
+        state->map = NULL;
+        state->map_size = 0;
+    }
+}
+#else
+#define map_file(state)
+#define unmap_file(state)
+#endif
+
+/*
+ * Copy up to count bytes from the mapping at raw_pos, or just skip them
+ * if buf is NULL; the caller updates raw_pos.  Returns 0 at the end of
+ * the file.
+ *
+ * Touching a page of a shared mapping that's past the end of the file
+ * raises SIGBUS, so check the file's size before every copy.  If the
+ * file has been truncated, or we can't tell, drop the mapping and go back
+ * to read() at raw_pos; the caller has to check state->map afterwards,
+ * and state->err if it's NULL.
+ */
+static guint
+map_read(FILE_T state, void *buf, guint count)
+{
+    ws_statb64 st;
+    gint64 left;
+
+    if (ws_fstat64(state->fd, &st) == -1 || st.st_size < state->map_size) {
+        unmap_file(state);
+        if (ws_lseek64(state->fd, state->raw_pos, SEEK_SET) == -1) {
+            state->err = errno;
+            state->err_info = NULL;
+        }
+        return 0;
+    }
+    if (state->raw_pos >= state->map_size && st.st_size > state->map_size) {
+        /* The file has grown since we mapped it. */
+        map_file(state);
+    }
+    left = state->map_size - state->raw_pos;
+    if (left <= 0)
+        return 0;
+    if ((gint64)count > left)
+        count = (guint)left;
+    if (buf != NULL)
+        memcpy(buf, state->map + state->raw_pos, count);
+    return count;
+}
+
 static int
 buf_read(FILE_T state, struct wtap_reader_buf *buf)
 {
     guint space_left, to_read;
     unsigned char *read_ptr;
-    ssize_t ret;
+    ssize_t ret = 0;
 
     /* How much space is left at the end of the buffer?
        XXX - the output buffer actually has state->size * 2 bytes. */
@@ -215,11 +324,19 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
         to_read = space_left;
     }
 
-    ret = ws_read(state->fd, read_ptr, to_read);
-    if (ret < 0) {
-        state->err = errno;
-        state->err_info = NULL;
-        return -1;
+    if (state->map != NULL) {
+        ret = map_read(state, read_ptr, to_read);
+        if (state->map == NULL && state->err != 0)
+            return -1;
+    }
+    if (state->map == NULL) {
+        /* Not mapped, or the mapping has just been dropped. */
+        ret = ws_read(state->fd, read_ptr, to_read);
+        if (ret < 0) {
+            state->err = errno;
+            state->err_info = NULL;
+            return -1;
+        }
     }
     if (ret == 0)
         state->eof = TRUE;
@@ -642,6 +759,71 @@ DIAG_ON(cast-qual)
 }
 #endif
 
+#ifdef HAVE_ZSTD
+/*
+ * Does the input buffer start with a Zstandard frame, or a skippable
+ * frame of the sort written by parallel compressors?
+ */
+static gboolean
+zstd_check_magic(FILE_T state)
+{
+    const unsigned char *p = state->in.next;
+
+    if (state->in.avail < 4)
+        return FALSE;
+    if (p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd)
+        return TRUE;
+    if ((p[0] & 0xf0) == 0x50 && p[1] == 0x2a && p[2] == 0x4d && p[3] == 0x18)
+        return TRUE;
+    return FALSE;
+}
+
+static void
+zstd_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    ZSTD_outBuffer output = {buf, count, 0};
+    ZSTD_inBuffer input;
+    size_t ret = 0;
+    size_t prev_pos;
+
+    /* fill output buffer up to end of frame or error */
+    do {
+        /* get more input */
+        if (state->in.avail == 0 && fill_in_buffer(state) == -1)
+            break;
+
+        /* The decoder might still have output to flush even if we
+           have no more input, so call it even then. */
+        input.src = state->in.next;
+        input.size = state->in.avail;
+        input.pos = 0;
+        prev_pos = output.pos;
+        ret = ZSTD_decompressStream(state->zstd_dctx, &output, &input);
+        state->in.next += input.pos;
+        state->in.avail -= (guint)input.pos;
+        if (ZSTD_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = ZSTD_getErrorName(ret);
+            break;
+        }
+        if (ret != 0 && input.size == 0 && output.pos == prev_pos) {
+            /* EOF in the middle of a frame */
+            state->err = WTAP_ERR_SHORT_READ;
+            state->err_info = NULL;
+            break;
+        }
+    } while (ret != 0 && output.pos < output.size);
+
+    /* update available output */
+    state->out.next = buf;
+    state->out.avail = (guint)output.pos;
+
+    /* at the end of a frame, look for another one */
+    if (ret == 0)
+        state->compression = UNKNOWN;
+}
+#endif
+
 static int
 gz_head(FILE_T state)
 {
@@ -808,6 +990,47 @@ gz_head(FILE_T state)
     /* { 0xFD, '7', 'z', 'X', 'Z', 0x00 } */
     /* FD 37 7A 58 5A 00 */
 #endif
+#ifdef HAVE_ZSTD
+    /* Make sure we have all four bytes of the magic number */
+    if (state->in.avail < 4 && !state->eof) {
+        if (state->in.next != state->in.buf) {
+            memmove(state->in.buf, state->in.next, state->in.avail);
+            state->in.next = state->in.buf;
+        }
+        if (fill_in_buffer(state) == -1)
+            return -1;
+    }
+    if (zstd_check_magic(state)) {
+        size_t ret;
+
+        if (state->zstd_dctx == NULL) {
+            state->zstd_dctx = ZSTD_createDStream();
+            if (state->zstd_dctx == NULL) {
+                state->err = ENOMEM;
+                state->err_info = NULL;
+                return -1;
+            }
+        }
+        ret = ZSTD_initDStream(state->zstd_dctx);
+        if (ZSTD_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = ZSTD_getErrorName(ret);
+            return -1;
+        }
+        state->compression = ZSTD;
+        state->is_compressed = TRUE;
+        state->is_zstd = TRUE;
+
+        /*
+         * Frames are compressed independently, so we can start
+         * decompressing at any of them; if the file was written
+         * with more than one frame, that gives us seek points.
+         */
+        if (state->fast_seek)
+            fast_seek_header(state, state->raw_pos - state->in.avail, state->pos, ZSTD);
+        return 0;
+    }
+#endif
 
     if (state->fast_seek)
         fast_seek_header(state, state->raw_pos - state->in.avail - state->out.avail, state->pos, UNCOMPRESSED);
@@ -848,6 +1071,11 @@ fill_out_buffer(FILE_T state)
     else if (state->compression == ZLIB) {      /* decompress */
         zlib_read(state, state->out.buf, state->size << 1);
     }
+#endif
+#ifdef HAVE_ZSTD
+    else if (state->compression == ZSTD) {      /* decompress */
+        zstd_read(state, state->out.buf, state->size << 1);
+    }
 #endif
     return 0;
 }
@@ -1060,9 +1288,17 @@ file_open(const char *path)
 }
 
 void
-file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek)
 {
     stream->fast_seek = seek;
+
+    /*
+     * Random access to an uncompressed file is a seek and a read for
+     * every record; if we can, map the file instead, so that's just a
+     * copy from the page cache.
+     */
+    if (random_flag)
+        map_file(stream);
 }
 
 gint64
@@ -1199,13 +1435,19 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             off = here->in;
             off2 = here->out;
         } else
+#endif
+#ifdef HAVE_ZSTD
+        if (here->compression == ZSTD) {
+            off = here->in;
+            off2 = here->out;
+        } else
 #endif
         {
             off2 = (file->pos + offset);
             off = here->in + (off2 - here->out);
         }
 
-        if (ws_lseek64(file->fd, off, SEEK_SET) == -1) {
+        if (file->map == NULL && ws_lseek64(file->fd, off, SEEK_SET) == -1) {
             *err = errno;
             return -1;
         }
@@ -1251,6 +1493,12 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             strm->adler = crc32(0L, Z_NULL, 0);
             file->compression = ZLIB;
         } else
+#endif
+#ifdef HAVE_ZSTD
+        if (here->compression == ZSTD) {
+            /* read the frame header again */
+            file->compression = UNKNOWN;
+        } else
 #endif
             file->compression = here->compression;
 
@@ -1285,7 +1533,8 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /*
          * Yes.  Just seek there within the file.
          */
-        if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
+        if (file->map == NULL &&
+            ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
         }
@@ -1319,7 +1568,8 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /* rewind, then skip to offset */
 
         /* back up and start over */
-        if (ws_lseek64(file->fd, file->start, SEEK_SET) == -1) {
+        if (file->map == NULL &&
+            ws_lseek64(file->fd, file->start, SEEK_SET) == -1) {
             *err = errno;
             return -1;
         }
@@ -1428,6 +1678,30 @@ file_read(void *buf, unsigned int len, FILE_T file)
                we're at the end of the input; just return
                with what we've gotten so far. */
             break;
+        } else if (file->map != NULL && file->compression == UNCOMPRESSED) {
+            /* We have nothing in the output buffer, and the
+               file is uncompressed and mapped; copy straight
+               from the mapping, without going through the
+               output buffer.  Empty the output buffer, so
+               that we don't seek backwards into stale data. */
+            buf_reset(&file->out);
+            n = map_read(file, buf, len);
+            if (file->map == NULL) {
+                /* The file was truncated; carry on with read(). */
+                if (file->err != 0)
+                    return -1;
+                continue;
+            }
+            if (n == 0) {
+                file->eof = TRUE;
+                continue;
+            }
+            if (buf != NULL)
+                buf = (char *)buf + n;
+            file->raw_pos += n;
+            len -= n;
+            got += n;
+            file->pos += n;
         } else {
             /* We have nothing in the output buffer, and
                we can generate more data; get more output,
@@ -1636,6 +1910,17 @@ file_fdreopen(FILE_T file, const char *path)
     if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
         return FALSE;
     file->fd = fd;
+
+    /*
+     * Put the new descriptor where the old one was (or, if the file's
+     * mapped, where it would have been), as seeks within the buffered
+     * data are done relative to the current position.
+     */
+    if (ws_lseek64(file->fd, file->raw_pos, SEEK_SET) == -1) {
+        ws_close(file->fd);
+        file->fd = -1;
+        return FALSE;
+    }
     return TRUE;
 }
 
@@ -1652,7 +1937,11 @@ file_close(FILE_T file)
         g_free(file->out.buf);
         g_free(file->in.buf);
     }
+#ifdef HAVE_ZSTD
+    ZSTD_freeDStream(file->zstd_dctx);
+#endif
     g_free(file->fast_seek_cur);
+    unmap_file(file);
     file->err = 0;
     file->err_info = NULL;
     g_free(file);
@@ -225,6 +225,108 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
     return TRUE;
 }
 
+/*
+ * State of the input files while reading records.
+ *
+ * When merging chronologically, the files that have a record present
+ * are kept in a binary min-heap ordered by the time stamps of those
+ * records, so that picking the next record doesn't mean looking at
+ * every input file.
+ */
+typedef struct {
+    merge_in_file_t  *in_files;     /* input file array */
+    merge_in_file_t **heap;         /* files with a record present */
+    guint             heap_count;   /* number of entries in heap */
+    merge_in_file_t  *last;         /* file of the record returned last */
+    gboolean          started;      /* TRUE once every file has been read */
+    guint             cur_file;     /* first file not at EOF, when appending */
+} merge_read_state_t;
+
+/*
+ * returns TRUE if the record in the first file is to be written before
+ * the record in the second file
+ *
+ * Records without time stamps are treated as earlier than all other
+ * records, and come in file order.  Records with the same time stamp
+ * come in reverse file order, as they always have.
+ */
+static gboolean
+merge_heap_before(const merge_read_state_t *state,
+                  merge_in_file_t *l, merge_in_file_t *r)
+{
+    gboolean l_has_ts = (l->rec.presence_flags & WTAP_HAS_TS) != 0;
+    gboolean r_has_ts = (r->rec.presence_flags & WTAP_HAS_TS) != 0;
+
+    if (!l_has_ts || !r_has_ts) {
+        if (l_has_ts != r_has_ts)
+            return !l_has_ts;
+        return l < r;
+    }
+    if (nstime_cmp(&l->rec.ts, &r->rec.ts) != 0)
+        return is_earlier(&l->rec.ts, &r->rec.ts);
+    return l - state->in_files > r - state->in_files;
+}
+
+static void
+merge_heap_sift_down(merge_read_state_t *state, guint i)
+{
+    merge_in_file_t **heap = state->heap;
+    merge_in_file_t *in_file = heap[i];
+
+    for (;;) {
+        guint child = 2 * i + 1;
+
+        if (child >= state->heap_count)
+            break;
+        if (child + 1 < state->heap_count &&
+            merge_heap_before(state, heap[child + 1], heap[child]))
+            child++;
+        if (!merge_heap_before(state, heap[child], in_file))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = in_file;
+}
+
+static void
+merge_heap_push(merge_read_state_t *state, merge_in_file_t *in_file)
+{
+    merge_in_file_t **heap = state->heap;
+    guint i = state->heap_count++;
+
+    while (i > 0) {
+        guint parent = (i - 1) / 2;
+
+        if (!merge_heap_before(state, in_file, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = in_file;
+}
+
+/** Read the next record from an input file, updating its state.
+ *
+ * @return FALSE on a read error, TRUE otherwise
+ */
+static gboolean
+merge_read_in_file(merge_in_file_t *in_file, int *err, gchar **err_info)
+{
+    gint64 data_offset;
+
+    if (!wtap_read(in_file->wth, &in_file->rec, &in_file->frame_buffer,
+                   err, err_info, &data_offset)) {
+        if (*err != 0) {
+            in_file->state = GOT_ERROR;
+            return FALSE;
+        }
+        in_file->state = AT_EOF;
+    } else
+        in_file->state = RECORD_PRESENT;
+    return TRUE;
+}
+
 /** Read the next packet, in chronological order, from the set of files to
  * be merged.
  *
@@ -238,7 +340,7 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * NULL.
  *
  * @param in_file_count number of entries in in_files
- * @param in_files input file array
+ * @param state read state of the input files
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -246,80 +348,61 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * all files
  */
 static merge_in_file_t *
-merge_read_packet(int in_file_count, merge_in_file_t in_files[],
+merge_read_packet(int in_file_count, merge_read_state_t *state,
                   int *err, gchar **err_info)
 {
+    merge_in_file_t *in_file;
     int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
-
-    /*
-     * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
-     */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
 
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
-            }
+    if (!state->started) {
+        /*
+         * Get the first record from each file, and put the files
+         * that have one in the heap.
+         */
+        for (i = 0; i < in_file_count; i++) {
+            in_file = &state->in_files[i];
+            if (!merge_read_in_file(in_file, err, err_info))
+                return in_file;
+            if (in_file->state == RECORD_PRESENT)
+                merge_heap_push(state, in_file);
         }
+        state->started = TRUE;
+    } else if (state->last != NULL) {
+        /*
+         * The file we returned last is at the top of the heap; replace
+         * its record with the next one, or drop it from the heap at EOF.
+         */
+        in_file = state->last;
+        state->last = NULL;
+        if (!merge_read_in_file(in_file, err, err_info))
+            return in_file;
+        if (in_file->state == AT_EOF)
+            state->heap[0] = state->heap[--state->heap_count];
+        if (state->heap_count > 0)
+            merge_heap_sift_down(state, 0);
     }
 
-    if (ei == -1) {
+    if (state->heap_count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    in_file = state->heap[0];
+
     /* We'll need to read another packet from this file. */
-    in_files[ei].state = RECORD_NOT_PRESENT;
+    in_file->state = RECORD_NOT_PRESENT;
+    state->last = in_file;
 
     /* Count this packet. */
-    in_files[ei].packet_num++;
+    in_file->packet_num++;
 
     /*
      * Return a pointer to the merge_in_file_t of the file from which the
      * packet was read.
      */
     *err = 0;
-    return &in_files[ei];
+    return in_file;
 }
 
 /** Read the next packet, in file sequence order, from the set of files
@@ -335,7 +418,7 @@ merge_read_packet(int in_file_count, merge_in_file_t in_files[],
  * NULL.
  *
  * @param in_file_count number of entries in in_files
- * @param in_files input file array
+ * @param state read state of the input files
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -343,16 +426,19 @@ merge_read_packet(int in_file_count, merge_in_file_t in_files[],
  * all files
  */
 static merge_in_file_t *
-merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
+merge_append_read_packet(int in_file_count, merge_read_state_t *state,
                          int *err, gchar **err_info)
 {
-    int i;
+    merge_in_file_t *in_files = state->in_files;
+    guint i;
     gint64 data_offset;
 
     /*
      * Find the first file not at EOF, and read the next packet from it.
+     * The files before state->cur_file are all at EOF, so don't look at
+     * them again.
      */
-    for (i = 0; i < in_file_count; i++) {
+    for (i = state->cur_file; i < (guint)in_file_count; i++) {
         if (in_files[i].state == AT_EOF)
             continue; /* This file is already at EOF */
         if (wtap_read(in_files[i].wth, &in_files[i].rec,
@@ -367,7 +453,8 @@ merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
         /* EOF - flag this file as being at EOF, and try the next one. */
         in_files[i].state = AT_EOF;
     }
-    if (i == in_file_count) {
+    state->cur_file = i;
+    if (i == (guint)in_file_count) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
@@ -851,16 +938,22 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
+    merge_read_state_t  read_state;
+
+    memset(&read_state, 0, sizeof read_state);
+    read_state.in_files = in_files;
+    if (!do_append)
+        read_state.heap = g_new(merge_in_file_t *, in_file_count);
 
     for (;;) {
         *err = 0;
 
         if (do_append) {
-            in_file = merge_append_read_packet(in_file_count, in_files, err,
+            in_file = merge_append_read_packet(in_file_count, &read_state, err,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(in_file_count, &read_state, err,
                                         err_info);
         }
 
@@ -942,6 +1035,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         }
     }
 
+    g_free(read_state.heap);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -1739,7 +1739,8 @@ void wtap_rec_cleanup(wtap_rec *rec);
  */
 typedef enum {
     WTAP_UNCOMPRESSED,
-    WTAP_GZIP_COMPRESSED
+    WTAP_GZIP_COMPRESSED,
+    WTAP_ZSTD_COMPRESSED        /* can be read, but not written */
 } wtap_compression_type;
 
 WS_DLL_PUBLIC
@@ -15,8 +15,20 @@
 
 #include "config.h"
 
+/* see bug 10798 and ws_mempbrk.c: don't use SSE4.2 with older Mac OSX
+   compilers. */
+#ifdef __APPLE__
+#if defined(__clang__) && (__clang_major__ >= 6)
+/* allow HAVE_SSE4_2 to be used for clang 6.0+ case because we know it works */
+#else
+/* don't allow it otherwise, for Mac OSX */
+#undef HAVE_SSE4_2
+#endif
+#endif
+
 #include <glib.h>
 #include <wsutil/crc32.h>
+#include "crc32_int.h"
 
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
@@ -365,14 +377,16 @@ crc32_ccitt_table_lookup (guchar pos)
 	return crc32_ccitt_table[pos];
 }
 
+#ifdef HAVE_SSE4_2
+/* -1 until we've checked whether the CPU has the CRC32 instruction */
+static int crc32c_use_sse42 = -1;
+#endif
+
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	crc = crc32c_calculate_no_swap(buf, len, crc);
 	return CRC32C_SWAP(crc);
 }
 
@@ -380,6 +394,14 @@ guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
 	const guint8 *p = (const guint8 *)buf;
+
+#ifdef HAVE_SSE4_2
+	if (crc32c_use_sse42 == -1)
+		crc32c_use_sse42 = crc32c_sse42_usable();
+	if (crc32c_use_sse42)
+		return crc32c_sse42_calculate_no_swap(buf, len, crc);
+#endif
+
 	while (len-- > 0) {
 		CRC32C(crc, *p++);
 	}
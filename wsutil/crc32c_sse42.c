@@ -0,0 +1,92 @@
+/* crc32c_sse42.c
+ * CRC-32C routine using the SSE4.2 CRC32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <glib.h>
+#include "ws_cpuid.h"
+
+#ifdef _WIN32
+  #include <tmmintrin.h>
+#endif
+
+#include <nmmintrin.h>
+#include <string.h>
+#include "crc32_int.h"
+
+gboolean
+crc32c_sse42_usable(void)
+{
+	return ws_cpuid_sse42() ? TRUE : FALSE;
+}
+
+/*
+ * The CRC32 instruction uses the same (reflected) polynomial as
+ * crc32c_table, and, like CRC32_ACCUMULATE(), does no inversion, so
+ * this gives exactly the same result as the table-driven loop.
+ */
+guint32
+crc32c_sse42_calculate_no_swap(const void *buf, int len, guint32 crc)
+{
+	const guint8 *p = (const guint8 *)buf;
+
+	/* Get to an 8-byte boundary, so the wide loads are aligned */
+	while (len > 0 && ((gintptr)p & 7) != 0) {
+		crc = _mm_crc32_u8(crc, *p++);
+		len--;
+	}
+
+#if defined(__x86_64__) || defined(_M_X64)
+	{
+		guint64 crc64 = crc;
+
+		while (len >= 8) {
+			guint64 v;
+
+			memcpy(&v, p, sizeof v);
+			crc64 = _mm_crc32_u64(crc64, v);
+			p += 8;
+			len -= 8;
+		}
+		crc = (guint32)crc64;
+	}
+#endif
+
+	while (len >= 4) {
+		guint32 v;
+
+		memcpy(&v, p, sizeof v);
+		crc = _mm_crc32_u32(crc, v);
+		p += 4;
+		len -= 4;
+	}
+
+	while (len-- > 0)
+		crc = _mm_crc32_u8(crc, *p++);
+
+	return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */